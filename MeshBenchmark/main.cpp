@@ -0,0 +1,235 @@
+#include "src/ECS/Scene.h"
+#include "src/ECS/Components/LoadedModel.h"
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <iomanip>
+#include <new>
+#include <string>
+#include <vector>
+
+/* CPU microbenchmarks for scene building and mesh loading, no Vulkan device is created.
+ * Scene::WriteGeometry writes into plain memory, so only the mesher/layout code is measured, once on the calling thread
+ * and once split across a ThreadPool.
+ *
+ * Items are voxels for the Scene and TerrainGenerator benchmarks and quads for the LoadedModel ones.
+ *
+ * usage: MeshBenchmark [--max-voxels N] [--min-time SECONDS]
+ */
+
+//every heap allocation in the process goes through here so allocations per operation can be reported
+static std::atomic<uint64_t> allocationCount{ 0 };
+
+void* operator new(size_t size)
+{
+	++allocationCount;
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { ++allocationCount; return std::malloc(size ? size : 1); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { ++allocationCount; return std::malloc(size ? size : 1); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+static double minimumSeconds = 0.25;
+static volatile uint64_t sink = 0; //results are folded in here so the optimizer can't drop the work
+
+//runs op until minimumSeconds have passed (at least 3 times) and prints the median time per item, throughput and allocations
+//bytes is what one run of op produces or consumes, 0 if throughput doesn't make sense
+template<typename Op>
+static void measure(const char* name, uint64_t items, uint64_t bytes, Op op)
+{
+	std::vector<double> seconds;
+	uint64_t allocations = 0;
+
+	//LoadedModel logs in DEBUG builds, keep that out of the timings
+	std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+
+	op(); //warm caches and the allocator
+
+	double total = 0.0;
+	while (seconds.size() < 3 || total < minimumSeconds)
+	{
+		uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+		auto start = std::chrono::high_resolution_clock::now();
+		op();
+		double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		allocations += allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+
+		seconds.push_back(elapsed);
+		total += elapsed;
+	}
+
+	std::cout.rdbuf(coutBuffer);
+	std::cout.clear();
+
+	std::sort(seconds.begin(), seconds.end());
+	double median = seconds[seconds.size() / 2];
+
+	std::cout << std::left << std::setw(28) << name << std::right
+		<< std::setw(10) << items
+		<< std::setw(14) << std::fixed << std::setprecision(2) << median * 1e9 / items;
+
+	if (bytes > 0) std::cout << std::setw(14) << std::setprecision(1) << bytes / median / (1024.0 * 1024.0);
+	else std::cout << std::setw(14) << "-";
+
+	std::cout << std::setw(14) << std::setprecision(1) << allocations / (double)seconds.size() << '\n';
+}
+
+static void fillScene(Scene& scene, uint32_t voxelCount)
+{
+	//same layout as VoxelGPU's main.cpp, a flat checkerboard
+	uint32_t side = (uint32_t)std::ceil(std::sqrt((double)voxelCount));
+	const glm::vec3 white(1.0f);
+	const glm::vec3 blue(0.0f, 0.0f, 1.0f);
+
+	for (uint32_t i = 0; i < voxelCount; ++i)
+	{
+		uint32_t x = i % side, z = i / side;
+		glm::vec3 position(x * 0.1f, 0.0f, z * 0.1f);
+		if ((x + z) % 2 == 0) scene.AddVoxel(TransformComponent(position), white, 1);
+		else scene.AddVoxel(TransformComponent(position), blue);
+	}
+}
+
+//a grid of quads sharing their corners, so vertex deduplication has work to do
+static std::string writeGridObj(uint32_t quads)
+{
+	uint32_t side = (uint32_t)std::ceil(std::sqrt((double)quads));
+	std::string path = (std::filesystem::temp_directory_path() / ("mesh_benchmark_" + std::to_string(quads) + ".obj")).string();
+
+	std::ofstream file(path);
+	if (!file.is_open()) throw std::runtime_error("Failed to write " + path + '\n');
+
+	for (uint32_t z = 0; z <= side; ++z)
+		for (uint32_t x = 0; x <= side; ++x)
+		{
+			file << "v " << x * 0.1f << " 0 " << z * 0.1f << '\n';
+			file << "vt " << x / (float)side << ' ' << z / (float)side << '\n';
+		}
+
+	uint32_t written = 0;
+	for (uint32_t z = 0; z < side && written < quads; ++z)
+		for (uint32_t x = 0; x < side && written < quads; ++x, ++written)
+		{
+			//obj indices are 1 based
+			uint32_t a = z * (side + 1) + x + 1, b = a + 1, c = a + side + 2, d = a + side + 1;
+			file << "f " << a << '/' << a << ' ' << d << '/' << d << ' ' << c << '/' << c << ' ' << b << '/' << b << '\n';
+		}
+
+	return path;
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t maxVoxels = 1000000;
+
+	try
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			if (arg == "--max-voxels" && i + 1 < argc) maxVoxels = (uint32_t)std::stoul(argv[++i]);
+			else if (arg == "--min-time" && i + 1 < argc) minimumSeconds = std::stod(argv[++i]);
+			else throw std::runtime_error("Unknown or incomplete argument: " + arg + '\n');
+		}
+
+		std::cout << std::left << std::setw(28) << "benchmark" << std::right << std::setw(10) << "items"
+			<< std::setw(14) << "ns/item" << std::setw(14) << "MiB/s" << std::setw(14) << "allocs/op" << '\n';
+
+		ThreadPool threadPool;
+
+		for (uint32_t voxels = 1000; voxels <= maxVoxels; voxels *= 10)
+		{
+			measure("Scene::AddVoxel", voxels, 0, [&]() {
+				Scene scene(nullptr, nullptr);
+				fillScene(scene, voxels);
+				sink = sink + scene.GetVoxelCount();
+			});
+
+			Scene scene(nullptr, nullptr);
+			fillScene(scene, voxels);
+
+			std::vector<Vertex> vertexData((size_t)voxels * VoxelModel::VERTICIES_PER_VOXEL);
+			std::vector<VertexIndex> indexData((size_t)voxels * VoxelModel::INDICES_PER_VOXEL);
+			uint64_t geometryBytes = vertexData.size() * sizeof(Vertex) + indexData.size() * sizeof(VertexIndex);
+
+			measure("Scene::WriteGeometry", voxels, geometryBytes, [&]() {
+				sink = sink + scene.WriteGeometry(vertexData.data(), indexData.data());
+				sink = sink + (uint64_t)vertexData.back().pos.x;
+			});
+
+			Scene pooledScene(nullptr, nullptr, &threadPool);
+			fillScene(pooledScene, voxels);
+
+			measure("Scene::WriteGeometry pool", voxels, geometryBytes, [&]() {
+				sink = sink + pooledScene.WriteGeometry(vertexData.data(), indexData.data());
+				sink = sink + (uint64_t)vertexData.back().pos.x;
+			});
+		}
+
+		//columns of 4 chunks, heights once per column like Scene::GenerateTerrain
+		const uint32_t terrainColumns = 256, chunksPerColumn = 4;
+		const uint64_t terrainVoxels = (uint64_t)terrainColumns * chunksPerColumn * CHUNK_VOLUME;
+		TerrainGenerator generator{ TerrainGenerator::Settings() };
+		std::vector<std::unique_ptr<Chunk>> terrainChunks;
+		for (uint32_t i = 0; i < terrainColumns * chunksPerColumn; ++i)
+			terrainChunks.emplace_back(new Chunk(glm::ivec3(i / chunksPerColumn % 16, -1 - (int)(i % chunksPerColumn), i / chunksPerColumn / 16)));
+
+		auto generateColumn = [&](uint32_t column, uint32_t) {
+			int32_t heights[CHUNK_SIZE * CHUNK_SIZE];
+			const glm::ivec3& position = terrainChunks[column * chunksPerColumn]->Position;
+			generator.ColumnHeights(position.x * CHUNK_SIZE, position.z * CHUNK_SIZE, heights);
+			for (uint32_t i = 0; i < chunksPerColumn; ++i) sink = sink + generator.FillChunk(*terrainChunks[column * chunksPerColumn + i], heights);
+		};
+
+		measure("TerrainGenerator", terrainVoxels, terrainVoxels * sizeof(GridVoxel), [&]() {
+			for (uint32_t column = 0; column < terrainColumns; ++column) generateColumn(column, 0);
+		});
+
+		measure("TerrainGenerator pool", terrainVoxels, terrainVoxels * sizeof(GridVoxel), [&]() {
+			threadPool.ParallelFor(terrainColumns, generateColumn);
+		});
+
+		//creating the chunks and lighting them as well
+		measure("Scene::GenerateTerrain pool", terrainVoxels, 0, [&]() {
+			Scene scene(nullptr, nullptr, &threadPool);
+			sink = sink + scene.GenerateTerrain(generator, glm::ivec3(0, -(int)chunksPerColumn, 0), glm::ivec3(15, -1, terrainColumns / 16 - 1));
+		});
+
+		for (uint32_t quads = 1000; quads <= maxVoxels / 4 && quads <= 1000000; quads *= 10)
+		{
+			std::string path = writeGridObj(quads);
+			uint64_t fileBytes = std::filesystem::file_size(path);
+
+			measure("LoadedModel parse", quads, fileBytes, [&]() {
+				LoadedModel model(path.c_str(), false);
+				sink = sink + model.getVertexDataSize();
+			});
+
+			measure("LoadedModel parse + dedup", quads, fileBytes, [&]() {
+				LoadedModel model(path.c_str(), true);
+				sink = sink + model.getVertexDataSize();
+			});
+
+			std::filesystem::remove(path);
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
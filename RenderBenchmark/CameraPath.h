@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+//camera poses over time, linearly interpolated between keyframes and sampled at fixed timesteps so every run sees the same frames
+class CameraPath
+{
+public:
+	struct Keyframe {
+		float time; //seconds
+		glm::vec3 position;
+		float yaw; //degrees, same convention as Camera
+		float pitch;
+	};
+
+private:
+	std::vector<Keyframe> keyframes;
+
+public:
+	//one keyframe per line: time x y z yaw pitch, lines starting with # are ignored
+	static CameraPath Load(const std::string& path)
+	{
+		std::ifstream file(path);
+		if (!file.is_open()) throw std::runtime_error("Failed to open camera path: " + path + '\n');
+
+		CameraPath result;
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line.empty() || line[0] == '#') continue;
+
+			std::istringstream in(line);
+			Keyframe k;
+			if (!(in >> k.time >> k.position.x >> k.position.y >> k.position.z >> k.yaw >> k.pitch)) throw std::runtime_error("Malformed camera path line: " + line + '\n');
+			if (!result.keyframes.empty() && k.time <= result.keyframes.back().time) throw std::runtime_error("Camera path keyframes must be in increasing time order\n");
+			result.keyframes.push_back(k);
+		}
+
+		if (result.keyframes.empty()) throw std::runtime_error("Camera path has no keyframes: " + path + '\n');
+		return result;
+	}
+
+	//circles center at the given radius and height once over duration, looking at the center
+	static CameraPath Orbit(const glm::vec3& center, float radius, float height, float duration, uint32_t steps = 64)
+	{
+		CameraPath result;
+		for (uint32_t i = 0; i <= steps; ++i)
+		{
+			float angle = 2.0f * 3.14159265f * i / steps;
+			glm::vec3 position = center + glm::vec3(std::cos(angle) * radius, height, std::sin(angle) * radius);
+			result.keyframes.push_back(lookAt(duration * i / steps, position, center));
+		}
+		return result;
+	}
+
+	//moves in a straight line from one side of the scene to the other, looking ahead and slightly down
+	static CameraPath Flyover(const glm::vec3& from, const glm::vec3& to, float duration)
+	{
+		CameraPath result;
+		glm::vec3 ahead = to + (to - from) + glm::vec3(0.0f, -(from.y + to.y) * 0.5f, 0.0f);
+		result.keyframes.push_back(lookAt(0.0f, from, ahead));
+		result.keyframes.push_back(lookAt(duration, to, ahead));
+		return result;
+	}
+
+	inline float getDuration() const { return keyframes.back().time; }
+
+	Keyframe Sample(float time) const
+	{
+		if (time <= keyframes.front().time) return keyframes.front();
+		if (time >= keyframes.back().time) return keyframes.back();
+
+		size_t next = 1;
+		while (keyframes[next].time < time) ++next;
+
+		const Keyframe& a = keyframes[next - 1];
+		const Keyframe& b = keyframes[next];
+		float t = (time - a.time) / (b.time - a.time);
+
+		//take the short way around for yaw
+		float yawDelta = std::fmod(b.yaw - a.yaw + 540.0f, 360.0f) - 180.0f;
+
+		return { time, glm::mix(a.position, b.position, t), a.yaw + yawDelta * t, a.pitch + (b.pitch - a.pitch) * t };
+	}
+
+private:
+	static Keyframe lookAt(float time, const glm::vec3& position, const glm::vec3& target)
+	{
+		glm::vec3 d = glm::normalize(target - position);
+		float yaw = glm::degrees(std::atan2(d.z, d.x));
+		float pitch = glm::degrees(std::asin(d.y));
+		return { time, position, yaw, pitch };
+	}
+};
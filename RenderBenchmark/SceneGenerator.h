@@ -0,0 +1,103 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <cmath>
+#include <stdexcept>
+
+#include "src/ECS/Scene.h"
+
+//deterministic benchmark scenes, the same parameters and seed always produce the same voxels in the same order
+namespace SceneGenerator {
+	enum Pattern { PATTERN_LAYER, PATTERN_CUBE, PATTERN_SPHERE };
+
+	struct Parameters {
+		uint32_t voxelCount = 10000;
+		float density = 0.5f; //fraction of the pattern's cells that are filled, (0, 1]
+		Pattern pattern = PATTERN_LAYER;
+		uint32_t seed = 1;
+	};
+
+	const float VOXEL_SPACING = 0.1f; //matches the size Scene::AddVoxel gives voxels
+
+	inline Pattern ParsePattern(const std::string& name) {
+		if (name == "layer") return PATTERN_LAYER;
+		if (name == "cube") return PATTERN_CUBE;
+		if (name == "sphere") return PATTERN_SPHERE;
+		throw std::runtime_error("Unknown scene pattern: " + name + " (expected layer, cube or sphere)\n");
+	}
+
+	inline const char* PatternName(Pattern pattern) {
+		switch (pattern) {
+		case PATTERN_LAYER: return "layer";
+		case PATTERN_CUBE: return "cube";
+		case PATTERN_SPHERE: return "sphere";
+		}
+		return "unknown";
+	}
+
+	//side length in cells of the pattern's bounding box, large enough that voxelCount / density cells fit in the pattern
+	inline uint32_t Extent(const Parameters& p) {
+		double cells = std::ceil(p.voxelCount / (double)p.density);
+		switch (p.pattern) {
+		case PATTERN_LAYER: return (uint32_t)std::ceil(std::sqrt(cells));
+		case PATTERN_CUBE: return (uint32_t)std::ceil(std::cbrt(cells));
+		case PATTERN_SPHERE: return (uint32_t)std::ceil(std::cbrt(cells * 6.0 / 3.14159265358979)) + 1; //sphere is pi/6 of its bounding cube
+		}
+		return 0;
+	}
+
+	//world space center of the generated scene, for pointing cameras at it
+	inline glm::vec3 Center(const Parameters& p) {
+		float half = Extent(p) * VOXEL_SPACING * 0.5f;
+		return glm::vec3(half, p.pattern == PATTERN_LAYER ? 0.0f : half, half);
+	}
+
+	inline bool insidePattern(const Parameters& p, uint32_t extent, uint32_t x, uint32_t y, uint32_t z) {
+		if (p.pattern != PATTERN_SPHERE) return true;
+
+		float r = extent * 0.5f;
+		float dx = x + 0.5f - r, dy = y + 0.5f - r, dz = z + 0.5f - r;
+		return dx * dx + dy * dy + dz * dz <= r * r;
+	}
+
+	//fills the scene with exactly voxelCount voxels spread uniformly over the pattern's cells (selection sampling),
+	//coloured like the checkerboard in VoxelGPU's main.cpp
+	void Generate(Scene& scene, const Parameters& p) {
+		if (p.density <= 0.0f || p.density > 1.0f) throw std::runtime_error("Scene density must be in (0, 1]\n");
+
+		uint32_t extent = Extent(p);
+		uint32_t height = p.pattern == PATTERN_LAYER ? 1 : extent;
+
+		uint64_t cells = 0;
+		for (uint32_t y = 0; y < height; ++y)
+			for (uint32_t z = 0; z < extent; ++z)
+				for (uint32_t x = 0; x < extent; ++x)
+					if (insidePattern(p, extent, x, y, z)) ++cells;
+
+		std::mt19937 rng(p.seed);
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+		const glm::vec3 white(1.0f);
+		const glm::vec3 blue(0.0f, 0.0f, 1.0f);
+
+		uint64_t remainingCells = cells;
+		uint64_t remainingVoxels = p.voxelCount < cells ? p.voxelCount : cells;
+
+		for (uint32_t y = 0; y < height && remainingVoxels > 0; ++y) {
+			for (uint32_t z = 0; z < extent && remainingVoxels > 0; ++z) {
+				for (uint32_t x = 0; x < extent && remainingVoxels > 0; ++x) {
+					if (!insidePattern(p, extent, x, y, z)) continue;
+
+					//keep this cell with probability (voxels still needed) / (cells left), always ends with exactly voxelCount
+					if (uniform(rng) * remainingCells < remainingVoxels) {
+						glm::vec3 position(x * VOXEL_SPACING, y * VOXEL_SPACING, z * VOXEL_SPACING);
+						if ((x + y + z) % 2 == 0) scene.AddVoxel(TransformComponent(position), white, 1);
+						else scene.AddVoxel(TransformComponent(position), blue);
+						--remainingVoxels;
+					}
+					--remainingCells;
+				}
+			}
+		}
+	}
+}
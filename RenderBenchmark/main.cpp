@@ -0,0 +1,208 @@
+#include "src/Renderer.h"
+#include "src/ECS/Scene.h"
+
+#include "SceneGenerator.h"
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <cstring>
+
+/* Render benchmark: builds a generated scene, flies the camera along a path at a fixed timestep and writes frame time
+ * statistics as JSON. Runs headless by default so it works on machines without a display (and on lavapipe).
+ *
+ * usage: RenderBenchmark [--voxels N] [--density D] [--pattern layer|cube|sphere] [--seed S]
+ *                        [--path orbit|flyover|<file>] [--frames N] [--warmup N] [--timestep SECONDS]
+ *                        [--out results.json] [--windowed]
+ *                        [--present-mode fifo|mailbox|immediate] [--frames-in-flight 1-3] [--low-latency]
+ *
+ * Must be run from the VoxelGPU directory so shaders/ and textures/ resolve.
+ */
+
+struct Statistics {
+	double mean = 0, p50 = 0, p95 = 0, p99 = 0, min = 0, max = 0;
+};
+
+static Statistics computeStatistics(std::vector<double> samples)
+{
+	Statistics s;
+	if (samples.empty()) return s;
+
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0;
+	for (double v : samples) sum += v;
+	s.mean = sum / samples.size();
+
+	//nearest rank percentiles
+	auto percentile = [&](double p) { return samples[std::min(samples.size() - 1, (size_t)std::ceil(p * samples.size()) - 1)]; };
+	s.p50 = percentile(0.50);
+	s.p95 = percentile(0.95);
+	s.p99 = percentile(0.99);
+	s.min = samples.front();
+	s.max = samples.back();
+	return s;
+}
+
+static void writeStatistics(std::ofstream& out, const char* name, const Statistics& s)
+{
+	out << "\t\"" << name << "\": { \"mean\": " << s.mean << ", \"p50\": " << s.p50 << ", \"p95\": " << s.p95
+		<< ", \"p99\": " << s.p99 << ", \"min\": " << s.min << ", \"max\": " << s.max << " },\n";
+}
+
+//the same names --present-mode takes
+static const char* presentModeName(VkPresentModeKHR presentMode)
+{
+	switch (presentMode) {
+	case VK_PRESENT_MODE_FIFO_KHR: return "fifo";
+	case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+	case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+	default: return "other";
+	}
+}
+
+int main(int argc, char** argv)
+{
+	SceneGenerator::Parameters sceneParameters;
+	std::string pathName = "orbit";
+	std::string outPath = "benchmark.json";
+	uint32_t frames = 600;
+	uint32_t warmupFrames = 60;
+	float timestep = 1.0f / 60.0f;
+	bool windowed = false;
+	std::string presentModeArg = "fifo"; //only matters when windowed
+	uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+	bool lowLatency = false;
+
+	try
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if (arg == "--voxels" && hasValue) sceneParameters.voxelCount = (uint32_t)std::stoul(argv[++i]);
+			else if (arg == "--density" && hasValue) sceneParameters.density = std::stof(argv[++i]);
+			else if (arg == "--pattern" && hasValue) sceneParameters.pattern = SceneGenerator::ParsePattern(argv[++i]);
+			else if (arg == "--seed" && hasValue) sceneParameters.seed = (uint32_t)std::stoul(argv[++i]);
+			else if (arg == "--path" && hasValue) pathName = argv[++i];
+			else if (arg == "--frames" && hasValue) frames = (uint32_t)std::stoul(argv[++i]);
+			else if (arg == "--warmup" && hasValue) warmupFrames = (uint32_t)std::stoul(argv[++i]);
+			else if (arg == "--timestep" && hasValue) timestep = std::stof(argv[++i]);
+			else if (arg == "--out" && hasValue) outPath = argv[++i];
+			else if (arg == "--windowed") windowed = true;
+			else if (arg == "--present-mode" && hasValue) presentModeArg = argv[++i];
+			else if (arg == "--frames-in-flight" && hasValue) framesInFlight = (uint32_t)std::stoul(argv[++i]);
+			else if (arg == "--low-latency") lowLatency = true;
+			else throw std::runtime_error("Unknown or incomplete argument: " + arg + '\n');
+		}
+
+		if (frames == 0) throw std::runtime_error("--frames must be at least 1\n");
+		if (framesInFlight < 1 || framesInFlight > MAX_FRAMES_IN_FLIGHT) throw std::runtime_error("--frames-in-flight must be between 1 and " + std::to_string(MAX_FRAMES_IN_FLIGHT) + '\n');
+
+		VkPresentModeKHR presentMode;
+		if (presentModeArg == "fifo") presentMode = VK_PRESENT_MODE_FIFO_KHR;
+		else if (presentModeArg == "mailbox") presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+		else if (presentModeArg == "immediate") presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+		else throw std::runtime_error("Unknown present mode: " + presentModeArg + '\n');
+
+		Renderer renderer(!windowed);
+		renderer.setPresentMode(presentMode);
+		renderer.setFramesInFlight(framesInFlight);
+		renderer.setLowLatencyMode(lowLatency);
+		Scene scene(renderer.getDeviceHandler(), renderer.getCommandBuffersHandler(), renderer.getThreadPool());
+
+		VkDeviceSize memoryBeforeScene = renderer.getDeviceHandler()->getAllocatedBytes();
+
+		auto buildStart = std::chrono::high_resolution_clock::now();
+		SceneGenerator::Generate(scene, sceneParameters);
+		scene.FinishScene();
+		double buildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - buildStart).count();
+
+		VkDeviceSize sceneBytes = renderer.getDeviceHandler()->getAllocatedBytes() - memoryBeforeScene;
+		renderer.scene = &scene;
+
+		glm::vec3 center = SceneGenerator::Center(sceneParameters);
+		float halfExtent = SceneGenerator::Extent(sceneParameters) * SceneGenerator::VOXEL_SPACING * 0.5f;
+		float radius = std::min(halfExtent * 1.5f + 1.0f, 8.0f); //the camera's far plane is at 10
+
+		CameraPath path;
+		if (pathName == "orbit") path = CameraPath::Orbit(center, radius, radius * 0.5f, frames * timestep);
+		else if (pathName == "flyover") path = CameraPath::Flyover(center + glm::vec3(-radius, 1.0f, -radius), center + glm::vec3(radius, 1.0f, radius), frames * timestep);
+		else path = CameraPath::Load(pathName);
+
+		std::vector<double> frameMs;
+		std::vector<double> gpuMs;
+		std::vector<double> latencyMs;
+		frameMs.reserve(frames);
+		gpuMs.reserve(frames);
+		latencyMs.reserve(frames);
+
+		renderer.setCameraInput(false); //the path owns the camera, a windowed run must not drift with the mouse
+
+		//warmup frames fill the pipeline and let clocks ramp up, they replay the start of the path
+		uint32_t totalFrames = warmupFrames + frames;
+		auto previous = std::chrono::high_resolution_clock::now();
+		for (uint32_t frame = 0; frame < totalFrames; ++frame)
+		{
+			if (windowed && glfwWindowShouldClose(renderer.getWindowPointer())) break;
+
+			//time comes from the frame number, not the clock, so every run renders the same poses
+			float time = frame < warmupFrames ? 0.0f : (frame - warmupFrames) * timestep;
+			CameraPath::Keyframe pose = path.Sample(time);
+			renderer.camera->SetPose(pose.position, pose.yaw, pose.pitch);
+
+			renderer.doLoop();
+
+			auto now = std::chrono::high_resolution_clock::now();
+			if (frame >= warmupFrames)
+			{
+				frameMs.push_back(std::chrono::duration<double, std::milli>(now - previous).count());
+				gpuMs.push_back(renderer.getProfiler().getLastGpuMs());
+				latencyMs.push_back(renderer.getProfiler().getLastLatencyMs());
+			}
+			previous = now;
+		}
+
+		vkDeviceWaitIdle(renderer.getDeviceHandler()->getLogicalDevice());
+
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(renderer.getDeviceHandler()->getPhysicalDevice(), &deviceProperties);
+		VkExtent2D extent = renderer.getRenderExtent();
+		DeviceHandler* deviceHandler = renderer.getDeviceHandler();
+
+		std::ofstream out(outPath);
+		if (!out.is_open()) throw std::runtime_error("Failed to open output file: " + outPath + '\n');
+
+		out << "{\n";
+		out << "\t\"device\": \"" << deviceProperties.deviceName << "\",\n";
+		out << "\t\"resolution\": [" << extent.width << ", " << extent.height << "],\n";
+		out << "\t\"headless\": " << (windowed ? "false" : "true") << ",\n";
+		out << "\t\"present_mode\": \"" << (windowed ? presentModeName(renderer.getPresentMode()) : "none") << "\",\n";
+		out << "\t\"frames_in_flight\": " << framesInFlight << ",\n";
+		out << "\t\"low_latency\": " << (lowLatency ? "true" : "false") << ",\n";
+		out << "\t\"scene\": { \"pattern\": \"" << SceneGenerator::PatternName(sceneParameters.pattern) << "\", \"voxels\": " << sceneParameters.voxelCount
+			<< ", \"density\": " << sceneParameters.density << ", \"seed\": " << sceneParameters.seed << ", \"build_ms\": " << buildMs << " },\n";
+		out << "\t\"path\": \"" << pathName << "\",\n";
+		out << "\t\"timestep\": " << timestep << ",\n";
+		out << "\t\"warmup_frames\": " << warmupFrames << ",\n";
+		out << "\t\"frames\": " << frameMs.size() << ",\n";
+		writeStatistics(out, "frame_ms", computeStatistics(frameMs));
+		writeStatistics(out, "gpu_ms", computeStatistics(gpuMs));
+		writeStatistics(out, "latency_ms", computeStatistics(latencyMs));
+		out << "\t\"gpu_memory\": { \"scene_bytes\": " << sceneBytes << ", \"total_bytes\": " << deviceHandler->getAllocatedBytes()
+			<< ", \"device_local_bytes\": " << deviceHandler->getDeviceLocalBytes() << ", \"peak_bytes\": " << deviceHandler->getPeakAllocatedBytes() << " }\n";
+		out << "}\n";
+
+		std::cout << "Benchmark results written to " << outPath << '\n';
+
+		renderer.terminate();
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,274 @@
+//offline converter from any stb_image readable image to a .vtex container (see src/vulkanHandlers/TextureContainer.h)
+//usage: TextureConverter <input image> [output.vtex] [--format bc1|bc3|rgba8] [--linear]
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "vendor/stb_image.h"
+
+#include "src/vulkanHandlers/TextureContainer.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+struct Image {
+	uint32_t width;
+	uint32_t height;
+	std::vector<uint8_t> pixels; //RGBA8
+};
+
+static float srgbToLinear[256];
+
+static uint8_t linearToSrgb(float v) {
+	v = std::clamp(v, 0.0f, 1.0f);
+	float s = v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+	return static_cast<uint8_t>(s * 255.0f + 0.5f);
+}
+
+//2x2 box filter, done in linear space for sRGB images so that mips don't darken
+static Image downsample(const Image& src, bool srgb) {
+	Image dst;
+	dst.width = std::max(src.width / 2, 1u);
+	dst.height = std::max(src.height / 2, 1u);
+	dst.pixels.resize((size_t)dst.width * dst.height * 4);
+
+	for (uint32_t y = 0; y < dst.height; ++y) {
+		for (uint32_t x = 0; x < dst.width; ++x) {
+			uint32_t x0 = std::min(x * 2, src.width - 1), x1 = std::min(x * 2 + 1, src.width - 1);
+			uint32_t y0 = std::min(y * 2, src.height - 1), y1 = std::min(y * 2 + 1, src.height - 1);
+			const uint8_t* p[4] = {
+				&src.pixels[((size_t)y0 * src.width + x0) * 4], &src.pixels[((size_t)y0 * src.width + x1) * 4],
+				&src.pixels[((size_t)y1 * src.width + x0) * 4], &src.pixels[((size_t)y1 * src.width + x1) * 4]
+			};
+
+			uint8_t* out = &dst.pixels[((size_t)y * dst.width + x) * 4];
+			for (int c = 0; c < 3; ++c) {
+				if (srgb) out[c] = linearToSrgb((srgbToLinear[p[0][c]] + srgbToLinear[p[1][c]] + srgbToLinear[p[2][c]] + srgbToLinear[p[3][c]]) * 0.25f);
+				else out[c] = static_cast<uint8_t>((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) / 4);
+			}
+			out[3] = static_cast<uint8_t>((p[0][3] + p[1][3] + p[2][3] + p[3][3] + 2) / 4);
+		}
+	}
+
+	return dst;
+}
+
+static uint16_t to565(const uint8_t* c) {
+	return static_cast<uint16_t>(((c[0] >> 3) << 11) | ((c[1] >> 2) << 5) | (c[2] >> 3));
+}
+
+static void from565(uint16_t v, int* c) {
+	c[0] = ((v >> 11) & 31) << 3 | ((v >> 11) & 31) >> 2;
+	c[1] = ((v >> 5) & 63) << 2 | ((v >> 5) & 63) >> 4;
+	c[2] = (v & 31) << 3 | (v & 31) >> 2;
+}
+
+//bounding box endpoint fit: good enough for voxel materials, and fast
+static void encodeColorBlock(const uint8_t block[16][4], uint8_t* out) {
+	int minC[3] = { 255, 255, 255 }, maxC[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; ++i) {
+		for (int c = 0; c < 3; ++c) {
+			minC[c] = std::min(minC[c], (int)block[i][c]);
+			maxC[c] = std::max(maxC[c], (int)block[i][c]);
+		}
+	}
+
+	//flip the box diagonal for green/blue if they are anticorrelated with red
+	int center[3] = { (minC[0] + maxC[0]) / 2, (minC[1] + maxC[1]) / 2, (minC[2] + maxC[2]) / 2 };
+	int covG = 0, covB = 0;
+	for (int i = 0; i < 16; ++i) {
+		int r = block[i][0] - center[0];
+		covG += r * (block[i][1] - center[1]);
+		covB += r * (block[i][2] - center[2]);
+	}
+	if (covG < 0) std::swap(minC[1], maxC[1]);
+	if (covB < 0) std::swap(minC[2], maxC[2]);
+
+	//inset by 1/16th of the range so the endpoints aren't wasted on outliers
+	uint8_t e0[3], e1[3];
+	for (int c = 0; c < 3; ++c) {
+		int inset = (maxC[c] - minC[c]) / 16;
+		e0[c] = static_cast<uint8_t>(std::clamp(maxC[c] - inset, 0, 255));
+		e1[c] = static_cast<uint8_t>(std::clamp(minC[c] + inset, 0, 255));
+	}
+
+	uint16_t c0 = to565(e0), c1 = to565(e1);
+	if (c0 < c1) std::swap(c0, c1); //c0 > c1 selects the 4 color mode
+
+	int palette[4][3];
+	from565(c0, palette[0]);
+	from565(c1, palette[1]);
+	for (int c = 0; c < 3; ++c) {
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	uint32_t indices = 0;
+	if (c0 != c1) {
+		for (int i = 0; i < 16; ++i) {
+			int best = 0, bestDist = INT32_MAX;
+			for (int p = 0; p < 4; ++p) {
+				int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+				int dist = dr * dr + dg * dg + db * db;
+				if (dist < bestDist) { bestDist = dist; best = p; }
+			}
+			indices |= static_cast<uint32_t>(best) << (i * 2);
+		}
+	}
+
+	out[0] = c0 & 0xFF; out[1] = c0 >> 8;
+	out[2] = c1 & 0xFF; out[3] = c1 >> 8;
+	for (int i = 0; i < 4; ++i) out[4 + i] = (indices >> (i * 8)) & 0xFF;
+}
+
+static void encodeAlphaBlock(const uint8_t block[16][4], uint8_t* out) {
+	int a0 = 0, a1 = 255;
+	for (int i = 0; i < 16; ++i) {
+		a0 = std::max(a0, (int)block[i][3]);
+		a1 = std::min(a1, (int)block[i][3]);
+	}
+
+	uint64_t indices = 0;
+	if (a0 != a1) { //a0 > a1 selects the 8 alpha mode
+		int palette[8] = { a0, a1 };
+		for (int p = 1; p < 7; ++p) palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+
+		for (int i = 0; i < 16; ++i) {
+			int best = 0, bestDist = INT32_MAX;
+			for (int p = 0; p < 8; ++p) {
+				int dist = std::abs(block[i][3] - palette[p]);
+				if (dist < bestDist) { bestDist = dist; best = p; }
+			}
+			indices |= static_cast<uint64_t>(best) << (i * 3);
+		}
+	}
+
+	out[0] = static_cast<uint8_t>(a0);
+	out[1] = static_cast<uint8_t>(a1);
+	for (int i = 0; i < 6; ++i) out[2 + i] = (indices >> (i * 8)) & 0xFF;
+}
+
+static void encodeLevel(const Image& image, VkFormat format, std::vector<uint8_t>& out) {
+	out.resize(TextureContainer::LevelSize(format, image.width, image.height));
+
+	if (!TextureContainer::IsBlockCompressed(format)) {
+		memcpy(out.data(), image.pixels.data(), out.size());
+		return;
+	}
+
+	bool hasAlphaBlock = TextureContainer::BytesPerBlock(format) == 16;
+	uint8_t* write = out.data();
+
+	for (uint32_t by = 0; by < image.height; by += 4) {
+		for (uint32_t bx = 0; bx < image.width; bx += 4) {
+			uint8_t block[16][4];
+			for (uint32_t i = 0; i < 16; ++i) { //edge blocks repeat the last row/column
+				uint32_t x = std::min(bx + i % 4, image.width - 1);
+				uint32_t y = std::min(by + i / 4, image.height - 1);
+				memcpy(block[i], &image.pixels[((size_t)y * image.width + x) * 4], 4);
+			}
+
+			if (hasAlphaBlock) {
+				encodeAlphaBlock(block, write);
+				write += 8;
+			}
+			encodeColorBlock(block, write);
+			write += 8;
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cerr << "usage: TextureConverter <input image> [output.vtex] [--format bc1|bc3|rgba8] [--linear]\n";
+		return EXIT_FAILURE;
+	}
+
+	std::string input = argv[1];
+	std::string output;
+	std::string formatName = "bc1";
+	bool srgb = true;
+
+	for (int i = 2; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--format" && i + 1 < argc) formatName = argv[++i];
+		else if (arg == "--linear") srgb = false;
+		else output = arg;
+	}
+
+	if (output.empty()) output = input.substr(0, input.find_last_of('.')) + ".vtex";
+
+	VkFormat format;
+	if (formatName == "bc1") format = srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	else if (formatName == "bc3") format = srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+	else if (formatName == "rgba8") format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+	else {
+		std::cerr << "Unknown format " << formatName << '\n';
+		return EXIT_FAILURE;
+	}
+
+	for (int i = 0; i < 256; ++i) {
+		float v = i / 255.0f;
+		srgbToLinear[i] = v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+	}
+
+	int texWidth, texHeight, texChannels;
+	stbi_uc* pixels = stbi_load(input.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+	if (!pixels) {
+		std::cerr << "Failed to load " << input << ": " << stbi_failure_reason() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	Image level;
+	level.width = static_cast<uint32_t>(texWidth);
+	level.height = static_cast<uint32_t>(texHeight);
+	level.pixels.assign(pixels, pixels + (size_t)texWidth * texHeight * 4);
+	stbi_image_free(pixels);
+
+	uint32_t mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
+
+	std::vector<std::vector<uint8_t>> levelData(mipLevels);
+	for (uint32_t i = 0; i < mipLevels; ++i) {
+		encodeLevel(level, format, levelData[i]);
+		if (i + 1 < mipLevels) level = downsample(level, srgb);
+	}
+
+	TextureContainer::Header header{};
+	header.magic = TextureContainer::MAGIC;
+	header.version = TextureContainer::VERSION;
+	header.format = static_cast<uint32_t>(format);
+	header.width = static_cast<uint32_t>(texWidth);
+	header.height = static_cast<uint32_t>(texHeight);
+	header.mipLevels = mipLevels;
+	header.layers = 1;
+
+	std::vector<TextureContainer::LevelIndex> levels(mipLevels);
+	uint64_t offset = TextureContainer::AlignUp(sizeof(header) + sizeof(TextureContainer::LevelIndex) * mipLevels);
+	for (uint32_t i = 0; i < mipLevels; ++i) {
+		levels[i].offset = offset;
+		levels[i].size = levelData[i].size();
+		offset = TextureContainer::AlignUp(offset + levels[i].size);
+	}
+
+	std::ofstream file(output, std::ios::binary);
+	if (!file.is_open()) {
+		std::cerr << "Failed to open " << output << " for writing\n";
+		return EXIT_FAILURE;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(levels.data()), sizeof(TextureContainer::LevelIndex) * mipLevels);
+
+	const char padding[TextureContainer::DATA_ALIGNMENT] = {};
+	for (uint32_t i = 0; i < mipLevels; ++i) {
+		file.write(padding, levels[i].offset - (uint64_t)file.tellp());
+		file.write(reinterpret_cast<const char*>(levelData[i].data()), levelData[i].size());
+	}
+
+	std::cout << input << " -> " << output << " (" << formatName << ", " << mipLevels << " mip levels, " << (uint64_t)file.tellp() << " bytes)\n";
+
+	return EXIT_SUCCESS;
+}
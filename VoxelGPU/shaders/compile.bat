@@ -1,2 +1,4 @@
 C:\VulkanSDK\1.3.290.0\Bin\glslc.exe shader.vert -o vert.spv
-C:\VulkanSDK\1.3.290.0\Bin\glslc.exe shader.frag -o frag.spv
\ No newline at end of file
+C:\VulkanSDK\1.3.290.0\Bin\glslc.exe shader.frag -o frag.spv
+C:\VulkanSDK\1.3.290.0\Bin\glslc.exe chunkmesh.comp -o chunkmesh.spv
+C:\VulkanSDK\1.3.290.0\Bin\glslc.exe terrain.comp -o terrain.spv
\ No newline at end of file
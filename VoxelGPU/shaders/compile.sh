@@ -1,2 +1,4 @@
 /usr/local/bin/glslc shader.vert -o vert.spv
-/usr/local/bin/glslc shader.frag -o frag.spv
\ No newline at end of file
+/usr/local/bin/glslc shader.frag -o frag.spv
+/usr/local/bin/glslc chunkmesh.comp -o chunkmesh.spv
+/usr/local/bin/glslc terrain.comp -o terrain.spv
\ No newline at end of file
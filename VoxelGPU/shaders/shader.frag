@@ -1,12 +1,17 @@
 #version 450
 
-layout(binding = 1) uniform sampler2D texSampler;
+//one layer per material, material 0 is untextured and layer n holds material n + 1
+layout(binding = 1) uniform sampler2DArray texSampler;
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragMaterial;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = vec4(fragColor,1.0);
+    vec4 albedo = vec4(1.0);
+    if (fragMaterial != 0u) albedo = texture(texSampler, vec3(fragTexCoord, float(fragMaterial - 1u)));
+
+    outColor = vec4(fragColor, 1.0) * albedo;
 }
@@ -6,7 +6,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "vulkanHandlers/UniformBuffers.h"
-#include "vulkanHandlers/SwapchainHandler.h"
+#include "vulkanHandlers/DeviceHandler.h"
 
 class Camera {
 	const glm::mat4 correction = glm::mat4(
@@ -32,14 +32,14 @@ class Camera {
 
 	UniformBuffers* uniformBuffers;
 	UniformBufferObject ubo;
-	SwapchainHandler* swapchainHandler;
+	VkExtent2D& extent; //swapchain or offscreen target extent, followed on resize
 
 public:
-	Camera(DeviceHandler* _dh, SwapchainHandler* _sh) : swapchainHandler(_sh) {
-		uniformBuffers = new UniformBuffers(_dh, _sh);
+	Camera(DeviceHandler* _dh, VkExtent2D& _extent) : extent(_extent) {
+		uniformBuffers = new UniformBuffers(_dh);
 		ubo.model = glm::mat4(1.0f);
 		ubo.view = glm::mat4(1.0f);
-		ubo.projection = correction * glm::perspective(glm::radians(45.0f), swapchainHandler->getSwapchainExtent().width / (float)swapchainHandler->getSwapchainExtent().height, 0.1f, 1000.0f);
+		ubo.projection = correction * glm::perspective(glm::radians(45.0f), extent.width / (float)extent.height, 0.1f, 1000.0f);
 		//ubo.projection[1][1] *= -1; //glm was originally for opengl which has the y clip coordinates inverted from Vulkan
 	}
 
@@ -54,7 +54,7 @@ public:
 
 	void Update(uint32_t currentFrame) {
 		ubo.model = glm::mat4(1.0f);
-		ubo.projection = glm::perspective(glm::radians(45.0f), swapchainHandler->getSwapchainExtent().width / (float)swapchainHandler->getSwapchainExtent().height, 0.1f, 10.0f);
+		ubo.projection = glm::perspective(glm::radians(45.0f), extent.width / (float)extent.height, 0.1f, 10.0f);
 		ubo.projection[1][1] *= -1; //glm was originally for opengl which has the y clip coordinates inverted from Vulkan
 		ubo.view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
 
@@ -80,16 +80,16 @@ public:
 		yaw += xoffset;
 		pitch += yoffset;
 
-		if (pitch > 89.0f) pitch = 89.0f;
-		else if (pitch < -89.0f) pitch = -89.0f;
-
-		cameraDirection.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-		cameraDirection.y = sin(glm::radians(pitch));
-		cameraDirection.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+		updateDirection();
+	}
 
-		//std::cout << cameraDirection.x << ' ' << cameraDirection.y << ' ' << cameraDirection.z << '\n';
-		//std::cout << '\t' << yaw << ' ' << pitch << '\n';
-		cameraFront = glm::normalize(cameraDirection);
+	//places the camera directly, used by scripted camera paths (yaw and pitch in degrees, same convention as the mouse)
+	void SetPose(const glm::vec3& position, float _yaw, float _pitch)
+	{
+		cameraPos = position;
+		yaw = _yaw;
+		pitch = _pitch;
+		updateDirection();
 	}
 
 	void InputCallback(GLFWwindow* window)
@@ -110,4 +110,19 @@ public:
 		if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
 			cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * finalSpeed;
 	}
+
+private:
+	void updateDirection()
+	{
+		if (pitch > 89.0f) pitch = 89.0f;
+		else if (pitch < -89.0f) pitch = -89.0f;
+
+		cameraDirection.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+		cameraDirection.y = sin(glm::radians(pitch));
+		cameraDirection.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+
+		//std::cout << cameraDirection.x << ' ' << cameraDirection.y << ' ' << cameraDirection.z << '\n';
+		//std::cout << '\t' << yaw << ' ' << pitch << '\n';
+		cameraFront = glm::normalize(cameraDirection);
+	}
 };
\ No newline at end of file
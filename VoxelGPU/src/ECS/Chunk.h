@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <array>
+#include <stdint.h>
+
+#include "src/Vertex.h"
+
+//the editable part of the world is a grid of voxels, split into CHUNK_SIZE^3 chunks that are meshed and uploaded on their own
+const int CHUNK_SHIFT = 4;
+const int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+const int CHUNK_VOLUME = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+constexpr float VOXEL_SIZE = 0.1f; //world size of a grid cell, the same as the voxels Scene::AddVoxel creates
+
+//the step across each face, indexed by VoxelModel::Face
+//a chunk's mesh is one draw with 16 bit indices: every face it can have (one per pair of neighbouring cells inside it,
+//plus the ones on its boundary) has to fit
+static_assert((3 * CHUNK_SIZE * CHUNK_SIZE * (CHUNK_SIZE - 1) + 6 * CHUNK_SIZE * CHUNK_SIZE) * 4 <= MAX_VERTICES_PER_DRAW, "A chunk's mesh can't be drawn with 16 bit indices");
+
+const int FACE_DIRECTIONS[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+
+//8 bytes, a chunk's voxels are 32KB
+struct GridVoxel
+{
+	uint32_t Color = 0xFFFFFF; //see PackColor
+	uint16_t Material = MATERIAL_NONE;
+	bool Solid = false;
+	uint8_t Emission = 0; //block light given off by solid voxels, 0 to LightEngine::MAX_LIGHT
+};
+
+//the order a chunk's faces are grouped in by direction (VoxelModel::Face values), all positive then all negative so the
+//groups a viewer outside the chunk can see are more often next to each other and drawn as one range
+const uint32_t FACE_GROUP_ORDER[6] = { 0, 2, 4, 1, 3, 5 };
+
+//where a chunk's mesh lives in ChunkBuffers, indices are relative to vertexOffset
+//its faces are grouped by direction in FACE_GROUP_ORDER, so those facing away from the viewer can be skipped as a whole
+struct ChunkMesh
+{
+	uint32_t vertexOffset = 0;
+	uint32_t vertexCount = 0;
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	std::array<uint32_t, 6> faceIndexCounts = {}; //indexed by VoxelModel::Face
+};
+
+struct Chunk
+{
+	glm::ivec3 Position; //in chunks, the chunk covers cells Position * CHUNK_SIZE to Position * CHUNK_SIZE + CHUNK_SIZE - 1
+	std::array<GridVoxel, CHUNK_VOLUME> Voxels;
+	uint32_t SolidCount = 0;
+
+	//per cell, sky light in the high 4 bits and block light in the low 4, written by LightEngine (by the chunk's worker)
+	//a new chunk is lit like open sky, which is what its cells were before it existed
+	std::array<uint8_t, CHUNK_VOLUME> Light;
+	bool LightChanged = false; //queued to be remeshed once the light is done propagating
+	uint8_t LightChangedBorders = 0; //a bit per VoxelModel::Face of the sides where cells' light changed
+
+	bool Dirty = false; //queued for remeshing
+	ChunkMesh Mesh;
+	uint32_t GpuSlot = UINT32_MAX; //where GpuChunkMesher keeps a copy of its cells, UINT32_MAX if it has none
+	uint32_t GpuTerrain = UINT32_MAX; //the GpuTerrainGenerator terrain it was generated from until its voxels are edited, or UINT32_MAX
+
+	//which faces can be seen through from each face (through the chunk's empty cells), a bit per VoxelModel::Face indexed
+	//by VoxelModel::Face, see ChunkVisibility. Updated when the chunk is remeshed, empty chunks connect everything
+	std::array<uint8_t, 6> Connections = { 0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F };
+
+	Chunk(const glm::ivec3& position) : Position(position) { Light.fill(0xF0); }
+
+	//x fastest, then z, then y
+	static inline uint32_t Index(int x, int y, int z) { return x + CHUNK_SIZE * (z + CHUNK_SIZE * y); }
+
+	inline GridVoxel& At(int x, int y, int z) { return Voxels[Index(x, y, z)]; }
+	inline const GridVoxel& At(int x, int y, int z) const { return Voxels[Index(x, y, z)]; }
+};
+
+//the chunks around a chunk, offsets -1 to 1 on each axis, x fastest then z then y like the cells, 13 is the chunk itself
+inline uint32_t NeighbourhoodIndex(int dx, int dy, int dz) { return (dx + 1) + 3 * ((dz + 1) + 3 * (dy + 1)); }
+
+//cell coordinates to the chunk holding them and the position inside it, floors for negative cells too
+inline glm::ivec3 CellToChunk(const glm::ivec3& cell) { return glm::ivec3(cell.x >> CHUNK_SHIFT, cell.y >> CHUNK_SHIFT, cell.z >> CHUNK_SHIFT); }
+inline glm::ivec3 CellToLocal(const glm::ivec3& cell) { return glm::ivec3(cell.x & (CHUNK_SIZE - 1), cell.y & (CHUNK_SIZE - 1), cell.z & (CHUNK_SIZE - 1)); }
+
+//the chunk a world position is in, clamped well past the range of chunk positions so far away positions don't overflow
+inline glm::ivec3 WorldToChunk(const glm::vec3& position)
+{
+	glm::vec3 chunk = glm::clamp(glm::floor(position / (VOXEL_SIZE * CHUNK_SIZE)), glm::vec3(-(1 << 22)), glm::vec3(1 << 22));
+	return glm::ivec3(chunk);
+}
+
+//which face groups of the chunk at position can face a viewer somewhere in chunks viewerMin to viewerMax, a bit per VoxelModel::Face
+//a +x face is at least a cell past the chunk's low x side, so it faces away from any viewer in a chunk with a lower x (the same for the others)
+inline uint32_t VisibleFaceMask(const glm::ivec3& position, const glm::ivec3& viewerMin, const glm::ivec3& viewerMax)
+{
+	uint32_t mask = 0;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (viewerMax[axis] >= position[axis]) mask |= 1u << (axis * 2); //positive face
+		if (viewerMin[axis] <= position[axis]) mask |= 1u << (axis * 2 + 1); //negative face
+	}
+	return mask;
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include <stdint.h>
+
+#include "Chunk.h"
+
+//the chunk directory of an unbounded, sparse world, an open addressing (linear probing) hash table keyed by chunk position
+//one thread (the one editing the scene) inserts and removes, any number of others can Find / GetNeighbourhood at the same time without locking
+//removed chunks and outgrown tables aren't freed right away but by Reclaim, so whatever a reader found stays valid until then
+class ChunkMap
+{
+	static const uint64_t EMPTY = UINT64_MAX;
+	static const uint64_t REMOVED = UINT64_MAX - 1; //removed slots are only reused when the table is rebuilt, so a slot's key never changes back
+	static const uint32_t MIN_CAPACITY = 64;
+
+	struct Slot
+	{
+		std::atomic<uint64_t> Key{ EMPTY };
+		std::atomic<Chunk*> Value{ nullptr };
+	};
+
+	struct Table
+	{
+		Slot* Slots;
+		uint32_t Capacity; //power of 2, at most half the slots are ever used so probing always finds an empty one
+
+		Table(uint32_t capacity) : Slots(new Slot[capacity]), Capacity(capacity) {}
+		~Table() { delete[] Slots; }
+	};
+
+	std::atomic<Table*> table;
+	uint32_t count = 0; //live chunks
+	uint32_t usedSlots = 0; //live and removed, what readers have to probe past
+
+	std::vector<Table*> retiredTables;
+	std::vector<Chunk*> retiredChunks;
+
+public:
+	//positions are 21 bit signed per axis, a million chunks (16 million cells) either way from the origin
+	static const int MAX_POSITION = (1 << 20) - 1;
+	static const int MIN_POSITION = -(1 << 20);
+
+	ChunkMap() : table(new Table(MIN_CAPACITY)) {}
+
+	~ChunkMap()
+	{
+		Reclaim();
+		ForEach([](Chunk* chunk) { delete chunk; });
+		delete table.load();
+	}
+
+	ChunkMap(const ChunkMap&) = delete;
+	ChunkMap& operator=(const ChunkMap&) = delete;
+
+	inline uint32_t getCount() const { return count; }
+
+	static inline bool InRange(const glm::ivec3& position)
+	{
+		return position.x >= MIN_POSITION && position.x <= MAX_POSITION && position.y >= MIN_POSITION && position.y <= MAX_POSITION && position.z >= MIN_POSITION && position.z <= MAX_POSITION;
+	}
+
+	//any thread, nullptr if there is no chunk there
+	Chunk* Find(const glm::ivec3& position) const
+	{
+		if (!InRange(position)) return nullptr;
+
+		uint64_t key = pack(position);
+		const Table* current = table.load(std::memory_order_acquire);
+		uint32_t mask = current->Capacity - 1;
+
+		for (uint32_t i = hash(key) & mask;; i = (i + 1) & mask)
+		{
+			uint64_t slotKey = current->Slots[i].Key.load(std::memory_order_acquire);
+			if (slotKey == key) return current->Slots[i].Value.load(std::memory_order_relaxed);
+			if (slotKey == EMPTY) return nullptr;
+		}
+	}
+
+	//any thread, the 3x3x3 chunks around (and including) position's, indexed by NeighbourhoodIndex, nullptr where there is none
+	void GetNeighbourhood(const glm::ivec3& position, const Chunk* neighbourhood[27]) const
+	{
+		for (int dy = -1; dy <= 1; ++dy)
+			for (int dz = -1; dz <= 1; ++dz)
+				for (int dx = -1; dx <= 1; ++dx)
+					neighbourhood[NeighbourhoodIndex(dx, dy, dz)] = Find(position + glm::ivec3(dx, dy, dz));
+	}
+
+	//writer thread only, creates an empty chunk if there is none
+	Chunk* GetOrCreate(const glm::ivec3& position)
+	{
+		Chunk* chunk = Find(position);
+		if (chunk != nullptr) return chunk;
+		if (!InRange(position)) throw std::runtime_error("Chunk position out of range!\n");
+
+		if ((usedSlots + 1) * 2 > table.load(std::memory_order_relaxed)->Capacity) rebuild();
+
+		chunk = new Chunk(position);
+		insert(table.load(std::memory_order_relaxed), pack(position), chunk);
+		++count;
+		++usedSlots;
+		return chunk;
+	}
+
+	//writer thread only, the chunk is freed by the next Reclaim
+	bool Remove(const glm::ivec3& position)
+	{
+		if (!InRange(position)) return false;
+
+		uint64_t key = pack(position);
+		Table* current = table.load(std::memory_order_relaxed);
+		uint32_t mask = current->Capacity - 1;
+
+		for (uint32_t i = hash(key) & mask;; i = (i + 1) & mask)
+		{
+			uint64_t slotKey = current->Slots[i].Key.load(std::memory_order_relaxed);
+			if (slotKey == EMPTY) return false;
+			if (slotKey != key) continue;
+
+			retiredChunks.push_back(current->Slots[i].Value.load(std::memory_order_relaxed));
+			current->Slots[i].Key.store(REMOVED, std::memory_order_release);
+			--count;
+			return true;
+		}
+	}
+
+	//writer thread only
+	template<typename Function>
+	void ForEach(Function function)
+	{
+		Table* current = table.load(std::memory_order_relaxed);
+		for (uint32_t i = 0; i < current->Capacity; ++i)
+		{
+			uint64_t slotKey = current->Slots[i].Key.load(std::memory_order_relaxed);
+			if (slotKey != EMPTY && slotKey != REMOVED) function(current->Slots[i].Value.load(std::memory_order_relaxed));
+		}
+	}
+
+	//writer thread only, frees what Remove and rebuilding left behind, no reader may still be using a chunk or be inside Find
+	void Reclaim()
+	{
+		for (Chunk* chunk : retiredChunks) delete chunk;
+		retiredChunks.clear();
+		for (Table* retired : retiredTables) delete retired;
+		retiredTables.clear();
+	}
+
+private:
+	static inline uint64_t pack(const glm::ivec3& position)
+	{
+		const uint64_t mask = (1ull << 21) - 1;
+		return (static_cast<uint64_t>(position.x - MIN_POSITION) & mask)
+			| ((static_cast<uint64_t>(position.y - MIN_POSITION) & mask) << 21)
+			| ((static_cast<uint64_t>(position.z - MIN_POSITION) & mask) << 42);
+	}
+
+	//murmur3's finalizer, neighbouring positions end up far apart
+	static inline uint32_t hash(uint64_t key)
+	{
+		key ^= key >> 33;
+		key *= 0xff51afd7ed558ccdull;
+		key ^= key >> 33;
+		key *= 0xc4ceb9fe1a85ec53ull;
+		key ^= key >> 33;
+		return static_cast<uint32_t>(key);
+	}
+
+	//the value is written before the key is published, a reader that sees the key sees the chunk
+	static void insert(Table* into, uint64_t key, Chunk* chunk)
+	{
+		uint32_t mask = into->Capacity - 1;
+		uint32_t i = hash(key) & mask;
+		while (into->Slots[i].Key.load(std::memory_order_relaxed) != EMPTY) i = (i + 1) & mask;
+
+		into->Slots[i].Value.store(chunk, std::memory_order_relaxed);
+		into->Slots[i].Key.store(key, std::memory_order_release);
+	}
+
+	//copies the live chunks into a new table (bigger if needed, otherwise just without the removed slots) and publishes it
+	//readers still probing the old one find the same chunks there, it is retired rather than freed
+	void rebuild()
+	{
+		uint32_t capacity = MIN_CAPACITY;
+		while (capacity < (count + 1) * 4) capacity *= 2;
+
+		Table* rebuilt = new Table(capacity);
+		ForEach([&](Chunk* chunk) { insert(rebuilt, pack(chunk->Position), chunk); });
+
+		retiredTables.push_back(table.exchange(rebuilt, std::memory_order_acq_rel));
+		usedSlots = count;
+	}
+};
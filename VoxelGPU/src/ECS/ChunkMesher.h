@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <vector>
+#include <stdint.h>
+
+#include "Chunk.h"
+#include "LightEngine.h"
+#include "Components/VoxelModel.h"
+#include "Components/CubeGeometry.h"
+
+//turns a chunk's voxels into triangles, only faces that aren't covered by a solid neighbour are emitted
+//each vertex is darkened by ambient occlusion from the cells around it and by the light of the cell in front of its face
+//(see LightEngine), both baked into its color
+//pure CPU and only reads the chunks, so different chunks can be meshed on different threads at once
+namespace ChunkMesher
+{
+	//how much light reaches a vertex at each occlusion level, 0 is a corner with both edges covered
+	constexpr float AO_LEVELS[4] = { 0.4f, 0.6f, 0.8f, 1.0f };
+
+	//how bright a face is at each light level, every level down is 80% of the one above
+	constexpr std::array<float, LightEngine::MAX_LIGHT + 1> LightLevels()
+	{
+		std::array<float, LightEngine::MAX_LIGHT + 1> levels{};
+		float brightness = 1.0f;
+		for (int level = LightEngine::MAX_LIGHT; level >= 0; --level)
+		{
+			levels[level] = brightness;
+			brightness *= 0.8f;
+		}
+		return levels;
+	}
+
+	constexpr std::array<float, LightEngine::MAX_LIGHT + 1> LIGHT_LEVELS = LightLevels();
+
+	//x, y, z may be up to one cell outside the chunk, those cells are looked up in the chunk around it
+	inline bool isSolid(const Chunk& chunk, const Chunk* const neighbourhood[27], int x, int y, int z)
+	{
+		if (x >= 0 && x < CHUNK_SIZE && y >= 0 && y < CHUNK_SIZE && z >= 0 && z < CHUNK_SIZE) return chunk.At(x, y, z).Solid;
+
+		const Chunk* neighbour = neighbourhood[NeighbourhoodIndex(x < 0 ? -1 : x >= CHUNK_SIZE, y < 0 ? -1 : y >= CHUNK_SIZE, z < 0 ? -1 : z >= CHUNK_SIZE)];
+		return neighbour != nullptr && neighbour->At(x & (CHUNK_SIZE - 1), y & (CHUNK_SIZE - 1), z & (CHUNK_SIZE - 1)).Solid;
+	}
+
+	//packed like Chunk::Light, cells without a chunk are open sky
+	inline uint8_t lightAt(const Chunk& chunk, const Chunk* const neighbourhood[27], int x, int y, int z)
+	{
+		if (x >= 0 && x < CHUNK_SIZE && y >= 0 && y < CHUNK_SIZE && z >= 0 && z < CHUNK_SIZE) return chunk.Light[Chunk::Index(x, y, z)];
+
+		const Chunk* neighbour = neighbourhood[NeighbourhoodIndex(x < 0 ? -1 : x >= CHUNK_SIZE, y < 0 ? -1 : y >= CHUNK_SIZE, z < 0 ? -1 : z >= CHUNK_SIZE)];
+		return neighbour != nullptr ? neighbour->Light[Chunk::Index(x & (CHUNK_SIZE - 1), y & (CHUNK_SIZE - 1), z & (CHUNK_SIZE - 1))] : LightEngine::OPEN_SKY;
+	}
+
+	//0 (darkest) to 3, from the three cells in front of the face that touch the corner: the two sharing an edge with it and
+	//the diagonal one, which can't be seen past two solid edges anyway
+	//a greedy mesher may only merge faces whose four corners have the same levels
+	inline uint32_t cornerOcclusion(const Chunk& chunk, const Chunk* const neighbourhood[27], int x, int y, int z, uint32_t face, uint32_t corner)
+	{
+		int axis = face / 2;
+		int tangent1 = (axis + 1) % 3, tangent2 = (axis + 2) % 3;
+
+		//the cell in front of the face, then a step towards the corner along both of the face's axes
+		int front[3] = { x + FACE_DIRECTIONS[face][0], y + FACE_DIRECTIONS[face][1], z + FACE_DIRECTIONS[face][2] };
+		int step1 = (corner & (4 >> tangent1)) ? 1 : -1;
+		int step2 = (corner & (4 >> tangent2)) ? 1 : -1;
+
+		int side1[3] = { front[0], front[1], front[2] };
+		side1[tangent1] += step1;
+		int side2[3] = { front[0], front[1], front[2] };
+		side2[tangent2] += step2;
+		int diagonal[3] = { side1[0], side1[1], side1[2] };
+		diagonal[tangent2] += step2;
+
+		bool solid1 = isSolid(chunk, neighbourhood, side1[0], side1[1], side1[2]);
+		bool solid2 = isSolid(chunk, neighbourhood, side2[0], side2[1], side2[2]);
+		if (solid1 && solid2) return 0;
+		return 3 - solid1 - solid2 - isSolid(chunk, neighbourhood, diagonal[0], diagonal[1], diagonal[2]);
+	}
+
+	//flood fills the chunk's empty cells, two faces are connected if one region of empty cells touches both
+	//indexed by VoxelModel::Face, each entry has a bit per VoxelModel::Face (see Chunk::Connections)
+	std::array<uint8_t, 6> FaceConnections(const Chunk& chunk)
+	{
+		std::array<uint8_t, 6> connections = {};
+		if (chunk.SolidCount == CHUNK_VOLUME) return connections;
+		if (chunk.SolidCount == 0) return { 0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F };
+
+		std::array<bool, CHUNK_VOLUME> visited = {};
+		std::vector<uint32_t> stack;
+		stack.reserve(CHUNK_VOLUME);
+
+		for (uint32_t start = 0; start < CHUNK_VOLUME; ++start)
+		{
+			if (visited[start] || chunk.Voxels[start].Solid) continue;
+
+			uint8_t touched = 0;
+			visited[start] = true;
+			stack.push_back(start);
+
+			while (!stack.empty())
+			{
+				uint32_t cell = stack.back();
+				stack.pop_back();
+
+				int x = cell & (CHUNK_SIZE - 1), z = (cell >> CHUNK_SHIFT) & (CHUNK_SIZE - 1), y = cell >> (2 * CHUNK_SHIFT);
+				for (uint32_t face = 0; face < 6; ++face)
+				{
+					int nx = x + FACE_DIRECTIONS[face][0], ny = y + FACE_DIRECTIONS[face][1], nz = z + FACE_DIRECTIONS[face][2];
+					if (nx < 0 || nx >= CHUNK_SIZE || ny < 0 || ny >= CHUNK_SIZE || nz < 0 || nz >= CHUNK_SIZE)
+					{
+						touched |= 1 << face;
+						continue;
+					}
+
+					uint32_t next = Chunk::Index(nx, ny, nz);
+					if (visited[next] || chunk.Voxels[next].Solid) continue;
+					visited[next] = true;
+					stack.push_back(next);
+				}
+			}
+
+			for (uint32_t face = 0; face < 6; ++face)
+				if (touched & (1 << face)) connections[face] |= touched;
+		}
+
+		return connections;
+	}
+
+	//a bit per cell of the chunk's row of cells along x at y, z, bit x for cell x, 0 for no chunk
+	inline uint32_t rowMask(const Chunk* chunk, int y, int z)
+	{
+		if (chunk == nullptr) return 0;
+
+		uint32_t mask = 0;
+		const GridVoxel* row = &chunk->Voxels[Chunk::Index(0, y, z)];
+		for (int x = 0; x < CHUNK_SIZE; ++x) mask |= static_cast<uint32_t>(row[x].Solid) << x;
+		return mask;
+	}
+
+	//where MeshChunk's faces would go without building them, from the cells' occupancy alone: the GPU mesher (see
+	//GpuChunkMesher) emits the same faces, each row of cells along x writing its own from rowOffsets on
+	//rowOffsets[(face * CHUNK_SIZE + y) * CHUNK_SIZE + z] gets the number of faces MeshChunk emits before the row's faces
+	//in that direction, faceIndexCounts the same as MeshChunk's. Returns the number of faces
+	uint32_t FaceLayout(const Chunk& chunk, const Chunk* const neighbourhood[27], uint32_t* rowOffsets, std::array<uint32_t, 6>& faceIndexCounts)
+	{
+		faceIndexCounts = {};
+		if (chunk.SolidCount == 0) return 0;
+
+		//every row of the chunk, and the rows of the chunks above, below and beside it that its faces look into
+		uint32_t masks[CHUNK_SIZE + 2][CHUNK_SIZE + 2] = {};
+		for (int y = -1; y <= CHUNK_SIZE; ++y)
+		{
+			for (int z = -1; z <= CHUNK_SIZE; ++z)
+			{
+				int dy = y < 0 ? -1 : y >= CHUNK_SIZE, dz = z < 0 ? -1 : z >= CHUNK_SIZE;
+				if (dy != 0 && dz != 0) continue; //diagonal, no face looks into it
+
+				const Chunk* owner = dy == 0 && dz == 0 ? &chunk : neighbourhood[NeighbourhoodIndex(0, dy, dz)];
+				masks[y + 1][z + 1] = rowMask(owner, y & (CHUNK_SIZE - 1), z & (CHUNK_SIZE - 1));
+			}
+		}
+
+		const uint32_t rowBits = (1u << CHUNK_SIZE) - 1;
+		uint32_t faces = 0;
+
+		for (uint32_t face : FACE_GROUP_ORDER)
+		{
+			uint32_t groupStart = faces;
+
+			for (int y = 0; y < CHUNK_SIZE; ++y)
+			{
+				for (int z = 0; z < CHUNK_SIZE; ++z)
+				{
+					//the cells in front of the row's faces, lined up with the cells they're in front of
+					uint32_t row = masks[y + 1][z + 1], front;
+					if (face == 0) front = (row >> 1) | (static_cast<uint32_t>(isSolid(chunk, neighbourhood, CHUNK_SIZE, y, z)) << (CHUNK_SIZE - 1));
+					else if (face == 1) front = ((row << 1) & rowBits) | static_cast<uint32_t>(isSolid(chunk, neighbourhood, -1, y, z));
+					else front = masks[y + 1 + FACE_DIRECTIONS[face][1]][z + 1 + FACE_DIRECTIONS[face][2]];
+
+					rowOffsets[(face * CHUNK_SIZE + y) * CHUNK_SIZE + z] = faces;
+					faces += static_cast<uint32_t>(std::popcount(row & ~front));
+				}
+			}
+
+			faceIndexCounts[face] = (faces - groupStart) * 6;
+		}
+
+		return faces;
+	}
+
+	//neighbourhood is the 3x3x3 chunks around it (see ChunkMap::GetNeighbourhood), nullptr where no chunk exists (its cells count as empty)
+	//vertices / indices are cleared first, the indices start at 0 for the chunk's first vertex (see the static_assert in Chunk.h)
+	//faces are emitted one direction at a time in FACE_GROUP_ORDER, faceIndexCounts gets each group's size by VoxelModel::Face
+	void MeshChunk(const Chunk& chunk, const Chunk* const neighbourhood[27], std::vector<Vertex>& vertices, std::vector<VertexIndex>& indices, std::array<uint32_t, 6>& faceIndexCounts)
+	{
+		static constexpr auto cubeX = CubeGeometry::Positions(0, VOXEL_SIZE);
+		static constexpr auto cubeY = CubeGeometry::Positions(1, VOXEL_SIZE);
+		static constexpr auto cubeZ = CubeGeometry::Positions(2, VOXEL_SIZE);
+
+		vertices.clear();
+		indices.clear();
+		faceIndexCounts = {};
+		if (chunk.SolidCount == 0) return;
+
+		glm::ivec3 chunkOrigin = chunk.Position * CHUNK_SIZE;
+
+		for (uint32_t face : FACE_GROUP_ORDER)
+		{
+			size_t groupStart = indices.size();
+
+			for (int y = 0; y < CHUNK_SIZE; ++y)
+			{
+				for (int z = 0; z < CHUNK_SIZE; ++z)
+				{
+					for (int x = 0; x < CHUNK_SIZE; ++x)
+					{
+						const GridVoxel& voxel = chunk.At(x, y, z);
+						if (!voxel.Solid) continue;
+
+						int nx = x + FACE_DIRECTIONS[face][0], ny = y + FACE_DIRECTIONS[face][1], nz = z + FACE_DIRECTIONS[face][2];
+						if (isSolid(chunk, neighbourhood, nx, ny, nz)) continue;
+
+						glm::vec3 origin = glm::vec3(chunkOrigin.x + x, chunkOrigin.y + y, chunkOrigin.z + z) * VOXEL_SIZE;
+						uint8_t light = lightAt(chunk, neighbourhood, nx, ny, nz);
+						glm::vec3 color = UnpackColor(voxel.Color) * LIGHT_LEVELS[std::max(LightEngine::SkyLight(light), LightEngine::BlockLight(light))];
+
+						uint32_t occlusion[4];
+						uint32_t base = static_cast<uint32_t>(vertices.size());
+						for (uint32_t i = 0; i < 4; ++i)
+						{
+							occlusion[i] = cornerOcclusion(chunk, neighbourhood, x, y, z, face, CubeGeometry::FACE_CORNERS[face][i]);
+
+							uint32_t v = face * 4 + i;
+							Vertex vertex;
+							vertex.pos = origin + glm::vec3(cubeX[v], cubeY[v], cubeZ[v]);
+							vertex.color = color * AO_LEVELS[occlusion[i]];
+							vertex.texCoord = glm::vec2(CubeGeometry::FACE_UVS[i][0], CubeGeometry::FACE_UVS[i][1]);
+							vertex.materialId = voxel.Material;
+							vertices.push_back(vertex);
+						}
+
+						//split the quad along the diagonal with more light, otherwise a single dark corner is smeared across the
+						//whole face and the shading depends on which way the face is turned
+						bool flip = occlusion[1] + occlusion[3] > occlusion[0] + occlusion[2];
+						const uint32_t* faceIndices = flip ? CubeGeometry::FLIPPED_FACE_INDICES : CubeGeometry::FACE_INDICES;
+						for (uint32_t i = 0; i < 6; ++i) indices.push_back(static_cast<VertexIndex>(base + faceIndices[i]));
+					}
+				}
+			}
+
+			faceIndexCounts[face] = static_cast<uint32_t>(indices.size() - groupStart);
+		}
+	}
+}
\ No newline at end of file
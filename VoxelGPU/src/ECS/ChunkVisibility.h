@@ -0,0 +1,135 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+#include "Chunk.h"
+#include "ChunkMap.h"
+
+//which chunks can be seen from the viewer's chunk at all, going by what each chunk can be seen through (Chunk::Connections)
+//a breadth first search out from the viewer: a chunk entered through one face can only be left through a face connected
+//to it, and never in the opposite of a direction already taken on the way there (a sight line doesn't turn back), so
+//chunks behind solid rock, like a cave system under the viewer, are never reached. Cells without a chunk are empty
+//the search stays within MAX_DISTANCE chunks of the viewer (and one chunk around the existing ones), anything past that
+//counts as visible. Only the CPU is involved, the result is a conservative superset of what's visible
+class ChunkVisibility
+{
+	struct Step
+	{
+		uint32_t Cell; //in the search box
+		uint8_t Entered; //the face it was entered through, 6 for where the search starts
+		uint8_t Directions; //a bit per direction taken to get here
+	};
+
+	glm::ivec3 boxMin = glm::ivec3(0), boxMax = glm::ivec3(-1);
+	glm::ivec3 boxSize = glm::ivec3(0);
+	std::vector<uint64_t> visited; //per cell of the box, a bit per way it was entered (see visitBit), and bit 63 if it's a start
+	std::vector<Step> queue;
+	uint32_t hiddenCount = 0;
+
+public:
+	static const int MAX_DISTANCE = 32; //in chunks
+
+	inline uint32_t getHiddenCount() { return hiddenCount; }
+
+	//searches from every chunk in viewerMin to viewerMax (the viewer may be anywhere in them)
+	void Update(ChunkMap& chunks, const glm::ivec3& viewerMin, const glm::ivec3& viewerMax)
+	{
+		glm::ivec3 chunksMin(INT32_MAX), chunksMax(INT32_MIN);
+		chunks.ForEach([&](Chunk* chunk) {
+			chunksMin = glm::min(chunksMin, chunk->Position);
+			chunksMax = glm::max(chunksMax, chunk->Position);
+		});
+
+		//the viewer, and space to go around the outside of the existing chunks, but not too far
+		boxMin = glm::max(glm::min(chunksMin - 1, viewerMin), viewerMin - MAX_DISTANCE);
+		boxMax = glm::min(glm::max(chunksMax + 1, viewerMax), viewerMax + MAX_DISTANCE);
+		boxSize = boxMax - boxMin + 1;
+
+		visited.assign((size_t)boxSize.x * boxSize.y * boxSize.z, 0);
+		queue.clear();
+
+		for (int y = viewerMin.y; y <= viewerMax.y; ++y)
+			for (int z = viewerMin.z; z <= viewerMax.z; ++z)
+				for (int x = viewerMin.x; x <= viewerMax.x; ++x)
+				{
+					uint32_t cell = cellIndex(glm::ivec3(x, y, z));
+					visited[cell] = START_BIT;
+					queue.push_back({ cell, 6, 0 });
+				}
+
+		for (size_t i = 0; i < queue.size(); ++i)
+		{
+			Step step = queue[i];
+			glm::ivec3 position = cellPosition(step.Cell);
+
+			//no chunk is empty space, it can be seen through from any face to any other
+			uint8_t exits = 0x3F;
+			if (step.Entered != 6)
+			{
+				const Chunk* chunk = chunks.Find(position);
+				if (chunk != nullptr) exits = chunk->Connections[step.Entered];
+			}
+
+			for (uint32_t face = 0; face < 6; ++face)
+			{
+				if (!(exits & (1 << face)) || (step.Directions & (1 << (face ^ 1)))) continue;
+
+				glm::ivec3 next = position + glm::ivec3(FACE_DIRECTIONS[face][0], FACE_DIRECTIONS[face][1], FACE_DIRECTIONS[face][2]);
+				if (!inBox(next)) continue;
+
+				//entered through the face opposite of the one it was left through. Each way in is only searched once, but the
+				//directions taken are part of it: the same face reached along another path may lead out to more of the chunk
+				uint32_t nextCell = cellIndex(next);
+				uint8_t nextEntered = static_cast<uint8_t>(face ^ 1);
+				uint8_t nextDirections = static_cast<uint8_t>(step.Directions | (1 << face));
+				uint64_t bit = visitBit(nextEntered, nextDirections);
+				if (visited[nextCell] & (bit | START_BIT)) continue;
+
+				visited[nextCell] |= bit;
+				queue.push_back({ nextCell, nextEntered, nextDirections });
+			}
+		}
+
+		hiddenCount = 0;
+		chunks.ForEach([&](Chunk* chunk) { if (!IsVisible(chunk->Position)) ++hiddenCount; });
+	}
+
+	//as of the last Update, chunks created since then are only known to be visible if they're outside the search
+	inline bool IsVisible(const glm::ivec3& position) const
+	{
+		return !inBox(position) || visited[cellIndex(position)] != 0;
+	}
+
+private:
+	static const uint64_t START_BIT = 1ull << 63;
+
+	//a sight line never takes both directions of an axis, so the entry face fixes its own axis and each of the other two
+	//is one of none, positive or negative: 9 direction sets per face, 54 bits
+	static inline uint64_t visitBit(uint8_t face, uint8_t directions)
+	{
+		uint32_t axis = face >> 1;
+		uint32_t first = (directions >> (2 * ((axis + 1) % 3))) & 3, second = (directions >> (2 * ((axis + 2) % 3))) & 3;
+		return 1ull << (face * 9 + first * 3 + second);
+	}
+
+	inline bool inBox(const glm::ivec3& position) const
+	{
+		return position.x >= boxMin.x && position.y >= boxMin.y && position.z >= boxMin.z && position.x <= boxMax.x && position.y <= boxMax.y && position.z <= boxMax.z;
+	}
+
+	inline uint32_t cellIndex(const glm::ivec3& position) const
+	{
+		glm::ivec3 local = position - boxMin;
+		return static_cast<uint32_t>(local.x + boxSize.x * (local.z + boxSize.z * local.y));
+	}
+
+	inline glm::ivec3 cellPosition(uint32_t cell) const
+	{
+		int x = cell % boxSize.x;
+		cell /= boxSize.x;
+		return boxMin + glm::ivec3(x, cell / boxSize.z, cell % boxSize.z);
+	}
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <stdint.h>
+
+//the geometry every voxel shares, as constant tables instead of vertex / index vectors per model
+//each face has its own 4 vertices (so it can carry its own texture coordinates and material), faces are in VoxelModel::Face order
+namespace CubeGeometry
+{
+	constexpr uint32_t VERTICES = 24;
+	constexpr uint32_t INDICES = 36;
+
+	//corner n is at (bit 2, bit 1, bit 0) of n on (x, y, z), each face lists its corners counter-clockwise
+	constexpr uint32_t FACE_CORNERS[6][4] = {
+		{ 6, 7, 5, 4 }, //+x face
+		{ 3, 2, 0, 1 }, //-x face
+		{ 3, 7, 6, 2 }, //+y face
+		{ 0, 4, 5, 1 }, //-y face
+		{ 7, 3, 1, 5 }, //+z face
+		{ 2, 6, 4, 0 }, //-z face
+	};
+
+	//per corner of a face, u then v
+	constexpr float FACE_UVS[4][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+
+	//two triangles fanned out from the face's first corner, relative to it
+	constexpr uint32_t FACE_INDICES[6] = { 0, 1, 2, 0, 2, 3 };
+	//the same face split along its other diagonal, from the second corner
+	constexpr uint32_t FLIPPED_FACE_INDICES[6] = { 1, 2, 3, 1, 3, 0 };
+
+	//one coordinate (0 = x, 1 = y, 2 = z) of all 24 vertices of a cube with edges of size, starting at the origin
+	constexpr std::array<float, VERTICES> Positions(uint32_t axis, float size)
+	{
+		std::array<float, VERTICES> positions{};
+		for (uint32_t face = 0; face < 6; ++face)
+			for (uint32_t i = 0; i < 4; ++i)
+				positions[face * 4 + i] = (FACE_CORNERS[face][i] & (4 >> axis)) ? size : 0.0f;
+		return positions;
+	}
+
+	constexpr std::array<uint16_t, INDICES> Indices()
+	{
+		std::array<uint16_t, INDICES> indices{};
+		for (uint32_t face = 0; face < 6; ++face)
+			for (uint32_t i = 0; i < 6; ++i)
+				indices[face * 6 + i] = static_cast<uint16_t>(face * 4 + FACE_INDICES[i]);
+		return indices;
+	}
+
+	constexpr std::array<uint16_t, INDICES> INDEX_DATA = Indices();
+}
@@ -9,16 +9,23 @@
 
 //#define OPTIMIZE_VERTICES
 
+#ifdef OPTIMIZE_VERTICES
+    const bool optimizeVerticesByDefault = true;
+#else
+    const bool optimizeVerticesByDefault = false;
+#endif
+
 class LoadedModel : public Model 
 {
 public:
 
-    LoadedModel(const char* path){
-        loadModel(path);
+    //optimizeVertices deduplicates identical vertices through a hash map instead of emitting one per index
+    LoadedModel(const char* path, bool optimizeVertices = optimizeVerticesByDefault){
+        loadModel(path, optimizeVertices);
     }
 
 private:
-    void loadModel(const char* path) {
+    void loadModel(const char* path, bool optimizeVertices) {
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
         std::vector<tinyobj::material_t> materials;
@@ -27,59 +34,65 @@ private:
         if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path))
             throw std::runtime_error(err+warn);
 
-        if(DEBUG) std::cout << "---Model loading messages for " << path << "---\n" << err+warn << "---End Model loading messages for " << path << "---\n";
+#ifdef DEBUG
+        std::cout << "---Model loading messages for " << path << "---\n" << err+warn << "---End Model loading messages for " << path << "---\n";
+#endif
 
-#ifdef OPTIMIZE_VERTICES
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+        if(optimizeVertices){
+            std::unordered_map<Vertex, uint32_t> uniqueVertices{};
 
-        for (const auto& shape : shapes) {
-            for (const auto& index : shape.mesh.indices) {
-                Vertex vertex{};
+            for (const auto& shape : shapes) {
+                for (const auto& index : shape.mesh.indices) {
+                    Vertex vertex{};
 
-                vertex.pos = {
-                    attrib.vertices[3 * index.vertex_index + 0],
-                    attrib.vertices[3 * index.vertex_index + 1],
-                    attrib.vertices[3 * index.vertex_index + 2]
-                };
+                    vertex.pos = {
+                        attrib.vertices[3 * index.vertex_index + 0],
+                        attrib.vertices[3 * index.vertex_index + 1],
+                        attrib.vertices[3 * index.vertex_index + 2]
+                    };
 
-                vertex.texCoord = {
-                    attrib.texcoords[2 * index.texcoord_index + 0],
-                    1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-                };
+                    vertex.texCoord = {
+                        attrib.texcoords[2 * index.texcoord_index + 0],
+                        1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+                    };
 
-                vertex.color = {1.0f, 1.0f, 1.0f};
+                    vertex.color = {1.0f, 1.0f, 1.0f};
 
-                if (uniqueVertices.count(vertex) == 0) {
-                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
-                }
+                    if (uniqueVertices.count(vertex) == 0) {
+                        uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+                        vertices.push_back(vertex);
+                    }
 
-                indices.push_back(uniqueVertices[vertex]);
+                    indices.push_back(uniqueVertices[vertex]);
+                }
             }
         }
-#else
-        for(const auto& shape : shapes){
-            for(const auto& index : shape.mesh.indices){
-                Vertex vertex{};
+        else{
+            for(const auto& shape : shapes){
+                for(const auto& index : shape.mesh.indices){
+                    Vertex vertex{};
 
-                vertex.pos = {
-                    attrib.vertices[3 * index.vertex_index + 0],
-                    attrib.vertices[3 * index.vertex_index + 1],
-                    attrib.vertices[3 * index.vertex_index + 2]
-                };
+                    vertex.pos = {
+                        attrib.vertices[3 * index.vertex_index + 0],
+                        attrib.vertices[3 * index.vertex_index + 1],
+                        attrib.vertices[3 * index.vertex_index + 2]
+                    };
 
-                vertex.texCoord = {
-                    attrib.texcoords[2 * index.texcoord_index + 0],
-                    1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-                };
+                    vertex.texCoord = {
+                        attrib.texcoords[2 * index.texcoord_index + 0],
+                        1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+                    };
 
-                vertex.color = {1.0f, 1.0f, 1.0f};
+                    vertex.color = {1.0f, 1.0f, 1.0f};
 
-                vertices.push_back(vertex);
-                indices.push_back(indices.size());
+                    vertices.push_back(vertex);
+                    indices.push_back(indices.size());
+                }
             }
         }
+
+#ifdef DEBUG
+        std::cout << "Final vertex count for model " << path << ": " << vertices.size() << '\n';
 #endif
-        if(DEBUG) std::cout << "Final vertex count for model " << path << ": " << vertices.size() << '\n';
     }
 };
\ No newline at end of file
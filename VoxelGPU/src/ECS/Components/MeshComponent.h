@@ -0,0 +1,16 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+#include "src/Vertex.h"
+
+//what an entity's cube looks like, the geometry itself is CubeGeometry's and shared by every voxel, so a voxel needs no model of its own
+struct MeshComponent
+{
+	uint32_t Color = 0xFFFFFF; //RGB, 8 bits each in the low 24 bits, no alpha (see PackColor)
+	uint32_t Material = MATERIAL_NONE;
+
+	MeshComponent() {}
+	MeshComponent(const glm::vec3& color, uint32_t material = MATERIAL_NONE) : Color(PackColor(color)), Material(material) {};
+};
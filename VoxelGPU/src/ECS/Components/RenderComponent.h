@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+
+//how an entity's geometry gets to the GPU
+struct RenderComponent
+{
+	uint32_t ObjectIndex = 0; //0 for static entities (baked into world space), otherwise the entity's model matrix in ObjectBuffers
+
+	RenderComponent() {}
+	RenderComponent(uint32_t objectIndex) : ObjectIndex(objectIndex) {};
+};
+
+//on dynamic entities whose transform changed since the last transform update
+struct TransformDirtyTag {};
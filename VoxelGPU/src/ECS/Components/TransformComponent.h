@@ -9,15 +9,16 @@
 struct TransformComponent
 {
 	glm::vec3 Translation = glm::vec3(0.0f);
-	glm::vec3 Rotation = glm::vec3(0.0f);
+	glm::vec3 Rotation = glm::vec3(0.0f); //euler angles in radians, applied as glm::quat(Rotation)
 	glm::vec3 Scale = glm::vec3(1.0f);
 
 	TransformComponent(){}
 	TransformComponent(const TransformComponent&) = default;
 	TransformComponent(const glm::vec3& t, const glm::vec3& r = glm::vec3(0.0f), const glm::vec3& s = glm::vec3(1.0f)) : Translation(t), Rotation(r), Scale(s) {};
 
+	//translation * rotation * scale, TransformBatch computes the same thing for many transforms at once
 	inline glm::mat4 GetTransformMatrix() const
 	{	
-		return glm::translate(glm::mat4(1.0f), Translation);
+		return glm::translate(glm::mat4(1.0f), Translation) * glm::toMat4(glm::quat(Rotation)) * glm::scale(glm::mat4(1.0f), Scale);
 	}
 };
\ No newline at end of file
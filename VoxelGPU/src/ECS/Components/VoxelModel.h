@@ -1,22 +1,33 @@
 #pragma once
 
+#include <array>
 
 #include "Model.h"
+#include "CubeGeometry.h"
 
 class VoxelModel : public Model
 {
 public:
-	static const uint32_t VERTICIES_PER_VOXEL = 8;
-	static const uint32_t INDICES_PER_VOXEL = 36;
+	//the scene and the chunk mesher build voxels straight from CubeGeometry, this is the same cube as a standalone model
+	static const uint32_t VERTICIES_PER_VOXEL = CubeGeometry::VERTICES;
+	static const uint32_t INDICES_PER_VOXEL = CubeGeometry::INDICES;
+
+	enum Face : uint32_t { POS_X = 0, NEG_X, POS_Y, NEG_Y, POS_Z, NEG_Z };
 
 	VoxelModel(const glm::vec3& size)
 	{
 		InitData(size.x, size.y, size.z);
 	}
 
-	VoxelModel(const glm::vec3& size, const glm::vec3& color)
+	VoxelModel(const glm::vec3& size, const glm::vec3& color, uint32_t material = MATERIAL_NONE)
 	{
-		InitData(size.x, size.y, size.z, color.r, color.g, color.b);
+		InitData(size.x, size.y, size.z, color.r, color.g, color.b, { material, material, material, material, material, material });
+	}
+
+	//faceMaterials is indexed by Face
+	VoxelModel(const glm::vec3& size, const glm::vec3& color, const std::array<uint32_t, 6>& faceMaterials)
+	{
+		InitData(size.x, size.y, size.z, color.r, color.g, color.b, faceMaterials);
 	}
 
 	VoxelModel()
@@ -24,29 +35,28 @@ public:
 		InitData(0.1f, 0.1f, 0.1f);
 	}
 
-	void InitData(float l, float w, float h, float r = 1.0f, float g = 1.0f, float b = 1.0f)
+	void InitData(float l, float w, float h, float r = 1.0f, float g = 1.0f, float b = 1.0f, const std::array<uint32_t, 6>& faceMaterials = {})
 	{
-		vertices =
+		vertices.clear();
+		indices.clear();
+		vertices.reserve(VERTICIES_PER_VOXEL);
+		indices.reserve(INDICES_PER_VOXEL);
+
+		for (uint32_t face = 0; face < 6; ++face)
 		{
-			Vertex(glm::vec3(0,0,0), glm::vec3(r, g, b), glm::vec2(0.0f, 0.0f)),//0
-			Vertex(glm::vec3(0,0,w), glm::vec3(r, g, b), glm::vec2(0.0f, 0.0f)),//1
-			Vertex(glm::vec3(0,h,0), glm::vec3(r, g, b), glm::vec2(0.0f, 0.0f)),//2
-			Vertex(glm::vec3(0,h,w), glm::vec3(r, g, b), glm::vec2(0.0f, 0.0f)),//3
-			Vertex(glm::vec3(l,0,0), glm::vec3(r, g, b), glm::vec2(0.0f, 0.0f)),//4
-			Vertex(glm::vec3(l,0,w), glm::vec3(r, g, b), glm::vec2(0.0f, 0.0f)),//5
-			Vertex(glm::vec3(l,h,0), glm::vec3(r, g, b), glm::vec2(0.0f, 0.0f)),//6
-			Vertex(glm::vec3(l,h,w), glm::vec3(r, g, b), glm::vec2(0.0f, 0.0f))//7
-		};
-
-		indices = {
-			0,2,4, 2,6,4, //-z face
-			3,0,1, 3,2,0, //-x face
-			7,1,5, 7,3,1, //+z face
-			6,5,4, 6,7,5, //+x face
-			3,6,2, 3,7,6, //+y face
-			0,5,1, 0,4,5, //-y face
-		};
+			uint32_t base = static_cast<uint32_t>(vertices.size());
+
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				uint32_t corner = CubeGeometry::FACE_CORNERS[face][i];
+				glm::vec3 pos((corner & 4) ? l : 0.0f, (corner & 2) ? h : 0.0f, (corner & 1) ? w : 0.0f);
+				glm::vec2 uv(CubeGeometry::FACE_UVS[i][0], CubeGeometry::FACE_UVS[i][1]);
+				vertices.push_back(Vertex(pos, glm::vec3(r, g, b), uv, faceMaterials[face]));
+			}
+
+			for (uint32_t i = 0; i < 6; ++i) indices.push_back(base + CubeGeometry::FACE_INDICES[i]);
+		}
 	}
 
 	~VoxelModel() {}
-};
\ No newline at end of file
+};
@@ -0,0 +1,472 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+#include "Chunk.h"
+#include "ChunkMap.h"
+#include "src/ThreadPool.h"
+
+//block light (given off by emissive voxels) and sky light, 0 to MAX_LIGHT per cell in Chunk::Light, kept up to date by only
+//propagating what an edit changed: the edit queues the cells it affects (CellChanged, ChunkCreated), then Propagate first
+//spreads darkness out from wherever light was taken away, then spreads light back in from whatever still lights those cells
+//light drops by one per step, except sky light at full strength which goes straight down without dropping
+//cells without a chunk are open sky (full sky light, no block light): they light the chunks next to them but never change,
+//which is why a chunk that's empty but not lit like open sky is kept (see IsOpenSky)
+//every chunk belongs to one worker (by a hash of its position) which alone writes its light, light that crosses into
+//another worker's chunk goes into that worker's outbox and is picked up in the next round, so the thread pool can work
+//on any number of chunks at once without locking
+class LightEngine
+{
+public:
+	static const uint8_t MAX_LIGHT = 15;
+	static const uint8_t OPEN_SKY = MAX_LIGHT << 4; //the packed light of cells without a chunk
+	static const size_t PARALLEL_MIN_ENTRIES = 4096; //rounds with less queued than this are run on the calling thread
+
+	static inline uint8_t SkyLight(uint8_t light) { return light >> 4; }
+	static inline uint8_t BlockLight(uint8_t light) { return light & MAX_LIGHT; }
+
+	//an empty chunk that is lit like open sky is no different from no chunk at all
+	static bool IsOpenSky(const Chunk& chunk)
+	{
+		if (chunk.SolidCount != 0) return false;
+		for (uint8_t light : chunk.Light)
+			if (light != OPEN_SKY) return false;
+		return true;
+	}
+
+private:
+	static const uint32_t UP = 2, DOWN = 3; //VoxelModel::Face
+
+	enum : uint8_t
+	{
+		ADD = 0, //spread the cell's light to its neighbours
+		OFFER = 1, //a neighbour lights the cell to Level
+		REMOVED = 2, //the cell's light (Level) was taken away, its neighbours may have been lit by it
+		CHECK = 3, //a neighbour's light (Level) was taken away, the cell may have been lit by it
+		KIND = 3,
+		SKY = 4, //sky light rather than block light
+		FROM_ABOVE = 8, //CHECK: the neighbour is the cell above
+	};
+
+	struct Entry
+	{
+		Chunk* Target;
+		uint16_t Cell;
+		uint8_t Level;
+		uint8_t Flags;
+	};
+
+	struct Worker
+	{
+		std::vector<Entry> removals; //REMOVED and CHECK, all of them are done before any additions
+		std::vector<Entry> additions; //ADD and OFFER
+		std::vector<std::vector<Entry>> outbox; //per worker, entries for its chunks
+		std::vector<Chunk*> changed; //chunks whose light changed, see Chunk::LightChanged
+	};
+
+	ChunkMap& chunks;
+	ThreadPool* threadPool; //nullptr propagates on the calling thread
+	std::vector<Worker> workers;
+
+public:
+	LightEngine(ChunkMap& _chunks, ThreadPool* _threadPool) : chunks(_chunks), threadPool(_threadPool)
+	{
+		uint32_t workerCount = threadPool != nullptr ? std::max(threadPool->getWorkerCount(), 1u) : 1;
+		workers.resize(workerCount);
+		for (Worker& worker : workers) worker.outbox.resize(workerCount);
+	}
+
+	//the editing thread, after a chunk is created (its cells start out empty and lit like open sky): columns under a chunk
+	//that isn't lit by open sky at its bottom are shaded, and block light from the chunks around it comes in
+	void ChunkCreated(Chunk* chunk)
+	{
+		Worker& worker = workers[owner(chunk)];
+		for (uint32_t face = 0; face < 6; ++face)
+		{
+			Chunk* neighbour = chunks.Find(chunk->Position + glm::ivec3(FACE_DIRECTIONS[face][0], FACE_DIRECTIONS[face][1], FACE_DIRECTIONS[face][2]));
+			if (neighbour == nullptr) continue;
+
+			//the neighbour's side facing the chunk, and the chunk's own cells against it
+			int axis = face / 2;
+			int neighbourSide = (face & 1) ? CHUNK_SIZE - 1 : 0;
+			for (int v = 0; v < CHUNK_SIZE; ++v)
+				for (int u = 0; u < CHUNK_SIZE; ++u)
+				{
+					int position[3];
+					position[axis] = neighbourSide;
+					position[(axis + 1) % 3] = u;
+					position[(axis + 2) % 3] = v;
+					uint32_t neighbourCell = Chunk::Index(position[0], position[1], position[2]);
+					position[axis] = CHUNK_SIZE - 1 - neighbourSide;
+					uint32_t cell = Chunk::Index(position[0], position[1], position[2]);
+
+					uint8_t light = neighbour->Light[neighbourCell];
+					if (BlockLight(light) > 1) workers[owner(neighbour)].additions.push_back({ neighbour, static_cast<uint16_t>(neighbourCell), 0, ADD });
+					if (face == UP && SkyLight(light) < MAX_LIGHT)
+					{
+						setLevel(worker, chunk, cell, true, 0);
+						worker.removals.push_back({ chunk, static_cast<uint16_t>(cell), MAX_LIGHT, REMOVED | SKY });
+					}
+				}
+		}
+	}
+
+	//the editing thread, after the chunk's cell was changed from before
+	void CellChanged(Chunk* chunk, uint32_t cell, const GridVoxel& before)
+	{
+		const GridVoxel& after = chunk->Voxels[cell];
+		uint8_t emissionBefore = before.Solid ? before.Emission : 0;
+		uint8_t emissionAfter = after.Solid ? after.Emission : 0;
+		if (before.Solid == after.Solid && emissionBefore == emissionAfter) return;
+
+		//whatever light the cell had, its own or passing through, is taken away
+		Worker& worker = workers[owner(chunk)];
+		uint8_t light = chunk->Light[cell];
+		if (SkyLight(light) > 0) worker.removals.push_back({ chunk, static_cast<uint16_t>(cell), SkyLight(light), REMOVED | SKY });
+		if (BlockLight(light) > 0) worker.removals.push_back({ chunk, static_cast<uint16_t>(cell), BlockLight(light), REMOVED });
+		setLight(worker, chunk, cell, 0);
+
+		if (emissionAfter > 0)
+		{
+			setLight(worker, chunk, cell, emissionAfter);
+			worker.additions.push_back({ chunk, static_cast<uint16_t>(cell), 0, ADD });
+		}
+
+		//an emptied cell is lit again by its neighbours
+		if (!after.Solid)
+		{
+			for (uint32_t face = 0; face < 6; ++face)
+			{
+				uint32_t next;
+				Chunk* neighbour = step(chunk, cell, face, next);
+				if (neighbour == nullptr)
+				{
+					worker.additions.push_back({ chunk, static_cast<uint16_t>(cell), openSkyLevel(face), OFFER | SKY });
+					continue;
+				}
+
+				Worker& neighbourWorker = workers[owner(neighbour)];
+				neighbourWorker.additions.push_back({ neighbour, static_cast<uint16_t>(next), 0, ADD | SKY });
+				neighbourWorker.additions.push_back({ neighbour, static_cast<uint16_t>(next), 0, ADD });
+			}
+		}
+	}
+
+	//the editing thread, after new chunks were filled in bulk (instead of ChunkCreated and CellChanged per cell)
+	//each column of cells is lit by the sky from the top down to its first solid cell, then everywhere the light isn't settled
+	//(next to a darker empty cell, a brighter chunk that existed before, or open sky) is queued for Propagate
+	//split across the thread pool by columns of chunks, then by chunk
+	void ChunksGenerated(std::vector<Chunk*> generated)
+	{
+		if (generated.empty()) return;
+
+		//top down within each column of chunks, so a chunk's light comes in from the one above it already being lit
+		std::sort(generated.begin(), generated.end(), [](const Chunk* a, const Chunk* b) {
+			if (a->Position.x != b->Position.x) return a->Position.x < b->Position.x;
+			if (a->Position.z != b->Position.z) return a->Position.z < b->Position.z;
+			return a->Position.y > b->Position.y;
+		});
+
+		std::vector<uint32_t> columnStarts;
+		for (uint32_t i = 0; i < generated.size(); ++i)
+			if (i == 0 || generated[i]->Position.x != generated[i - 1]->Position.x || generated[i]->Position.z != generated[i - 1]->Position.z) columnStarts.push_back(i);
+		columnStarts.push_back(static_cast<uint32_t>(generated.size()));
+
+		auto lightColumn = [&](uint32_t column, uint32_t) {
+			for (uint32_t i = columnStarts[column]; i < columnStarts[column + 1]; ++i) skyColumns(generated[i]);
+		};
+		parallelFor(static_cast<uint32_t>(columnStarts.size() - 1), lightColumn);
+
+		//sorted by pointer so the seeding can tell generated neighbours from ones that existed before
+		std::vector<Chunk*> sorted = generated;
+		std::sort(sorted.begin(), sorted.end());
+		auto seed = [&](uint32_t task, uint32_t worker) { seedGenerated(generated[task], sorted, workers[worker]); };
+		parallelFor(static_cast<uint32_t>(generated.size()), seed);
+
+		uint32_t workerCount = static_cast<uint32_t>(workers.size());
+		for (uint32_t from = 0; from < workerCount; ++from)
+			for (uint32_t to = 0; to < workerCount; ++to)
+			{
+				std::vector<Entry>& outbox = workers[from].outbox[to];
+				for (const Entry& entry : outbox) send(to, entry);
+				outbox.clear();
+			}
+	}
+
+	//the editing thread, once no one else reads or writes the chunks' light: runs everything queued since the last call,
+	//changedChunk(Chunk*, uint8_t borders) is called for each chunk whose light changed, borders has a bit per VoxelModel::Face
+	//of the chunk's sides that cells with changed light are on (the neighbour there meshes faces lit by them)
+	template<typename Function>
+	void Propagate(Function changedChunk)
+	{
+		runPhase(true);
+		runPhase(false);
+
+		for (Worker& worker : workers)
+		{
+			for (Chunk* chunk : worker.changed)
+			{
+				changedChunk(chunk, chunk->LightChangedBorders);
+				chunk->LightChanged = false;
+				chunk->LightChangedBorders = 0;
+			}
+			worker.changed.clear();
+		}
+	}
+
+private:
+	//hashed rather than by position, so the chunks a change spreads through are spread across the workers
+	inline uint32_t owner(const Chunk* chunk) const
+	{
+		uint32_t hash = static_cast<uint32_t>(chunk->Position.x) * 73856093u ^ static_cast<uint32_t>(chunk->Position.y) * 19349663u ^ static_cast<uint32_t>(chunk->Position.z) * 83492791u;
+		return hash % static_cast<uint32_t>(workers.size());
+	}
+
+	//what open sky across face lights a cell to
+	static inline uint8_t openSkyLevel(uint32_t face) { return face == UP ? MAX_LIGHT : MAX_LIGHT - 1; }
+
+	//what a cell at level lights its neighbour across face to
+	static inline uint8_t spreadLevel(uint8_t level, bool sky, uint32_t face)
+	{
+		if (sky && face == DOWN && level == MAX_LIGHT) return MAX_LIGHT;
+		return level > 0 ? static_cast<uint8_t>(level - 1) : 0;
+	}
+
+	template<typename Function>
+	void parallelFor(uint32_t taskCount, Function function)
+	{
+		if (threadPool != nullptr && taskCount > 1) threadPool->ParallelFor(taskCount, function);
+		else for (uint32_t task = 0; task < taskCount; ++task) function(task, 0);
+	}
+
+	//a generated chunk's own light, without spreading it: full sky light down to the first solid cell of each column, block
+	//light only in emitters. The chunk above has to be lit already
+	void skyColumns(Chunk* chunk)
+	{
+		const Chunk* above = chunks.Find(chunk->Position + glm::ivec3(0, 1, 0));
+		for (int z = 0; z < CHUNK_SIZE; ++z)
+			for (int x = 0; x < CHUNK_SIZE; ++x)
+			{
+				bool open = above == nullptr || SkyLight(above->Light[Chunk::Index(x, 0, z)]) == MAX_LIGHT;
+				for (int y = CHUNK_SIZE - 1; y >= 0; --y)
+				{
+					uint32_t cell = Chunk::Index(x, y, z);
+					const GridVoxel& voxel = chunk->Voxels[cell];
+					if (voxel.Solid) open = false;
+					chunk->Light[cell] = voxel.Solid ? voxel.Emission : open ? OPEN_SKY : 0;
+				}
+			}
+	}
+
+	//queues (in worker's outboxes) every cell of a generated chunk whose light isn't settled with its neighbours: it would
+	//light a neighbour brighter, or a neighbour that isn't generated or open sky would light it brighter, and where the cells
+	//next to a chunk that existed before were open sky to it, the light they gave is taken back
+	void seedGenerated(Chunk* chunk, const std::vector<Chunk*>& generated, Worker& worker)
+	{
+		auto queue = [&](const Entry& entry) { worker.outbox[owner(entry.Target)].push_back(entry); };
+
+		Chunk* neighbours[6];
+		bool existed[6]; //a neighbour that isn't generated
+		bool anyExisted = false;
+		for (uint32_t face = 0; face < 6; ++face)
+		{
+			neighbours[face] = chunks.Find(chunk->Position + glm::ivec3(FACE_DIRECTIONS[face][0], FACE_DIRECTIONS[face][1], FACE_DIRECTIONS[face][2]));
+			existed[face] = neighbours[face] != nullptr && !std::binary_search(generated.begin(), generated.end(), neighbours[face]);
+			anyExisted |= existed[face];
+		}
+
+		for (uint32_t cell = 0; cell < CHUNK_VOLUME; ++cell)
+		{
+			uint8_t light = chunk->Light[cell];
+			bool solid = chunk->Voxels[cell].Solid;
+			if (solid && light == 0 && !anyExisted) continue; //most of the ground, it neither lights nor is lit by anything
+			bool takenBack = false;
+
+			for (uint32_t face = 0; face < 6; ++face)
+			{
+				uint32_t next;
+				Chunk* neighbour = step(chunk, cell, face, next, neighbours);
+				bool outside = neighbour != chunk;
+				uint32_t toward = face ^ 1; //the face of the neighbour's cell this one is across
+
+				if (neighbour == nullptr)
+				{
+					if (!solid && SkyLight(light) < openSkyLevel(face)) queue({ chunk, static_cast<uint16_t>(cell), openSkyLevel(face), OFFER | SKY });
+					continue;
+				}
+
+				uint8_t neighbourLight = neighbour->Light[next];
+				bool neighbourSolid = neighbour->Voxels[next].Solid;
+				for (uint32_t channel = 0; channel < 2; ++channel)
+				{
+					bool sky = channel == 1;
+					uint8_t flags = sky ? SKY : 0;
+					uint8_t level = sky ? SkyLight(light) : BlockLight(light);
+					uint8_t neighbourLevel = sky ? SkyLight(neighbourLight) : BlockLight(neighbourLight);
+
+					if (!neighbourSolid && spreadLevel(level, sky, face) > neighbourLevel) queue({ chunk, static_cast<uint16_t>(cell), 0, static_cast<uint8_t>(ADD | flags) });
+					if (outside && existed[face] && !solid && spreadLevel(neighbourLevel, sky, toward) > level) queue({ neighbour, static_cast<uint16_t>(next), 0, static_cast<uint8_t>(ADD | flags) });
+				}
+
+				if (outside && existed[face] && SkyLight(light) < MAX_LIGHT) takenBack = true;
+			}
+
+			if (takenBack) queue({ chunk, static_cast<uint16_t>(cell), MAX_LIGHT, REMOVED | SKY });
+		}
+	}
+
+	//the chunk and cell a step across face from chunk's cell, nullptr if there is no chunk there
+	//neighbours are the chunks across each face if the caller already looked them up
+	inline Chunk* step(Chunk* chunk, uint32_t cell, uint32_t face, uint32_t& next, Chunk* const* neighbours = nullptr) const
+	{
+		int x = (cell & (CHUNK_SIZE - 1)) + FACE_DIRECTIONS[face][0];
+		int z = ((cell >> CHUNK_SHIFT) & (CHUNK_SIZE - 1)) + FACE_DIRECTIONS[face][2];
+		int y = (cell >> (2 * CHUNK_SHIFT)) + FACE_DIRECTIONS[face][1];
+		next = Chunk::Index(x & (CHUNK_SIZE - 1), y & (CHUNK_SIZE - 1), z & (CHUNK_SIZE - 1));
+
+		if (x >= 0 && x < CHUNK_SIZE && y >= 0 && y < CHUNK_SIZE && z >= 0 && z < CHUNK_SIZE) return chunk;
+		if (neighbours != nullptr) return neighbours[face];
+		return chunks.Find(chunk->Position + glm::ivec3(FACE_DIRECTIONS[face][0], FACE_DIRECTIONS[face][1], FACE_DIRECTIONS[face][2]));
+	}
+
+	//only by the chunk's worker
+	inline void setLight(Worker& worker, Chunk* chunk, uint32_t cell, uint8_t light)
+	{
+		chunk->Light[cell] = light;
+
+		if (!chunk->LightChanged)
+		{
+			chunk->LightChanged = true;
+			worker.changed.push_back(chunk);
+		}
+
+		int x = cell & (CHUNK_SIZE - 1), z = (cell >> CHUNK_SHIFT) & (CHUNK_SIZE - 1), y = cell >> (2 * CHUNK_SHIFT);
+		if (x == CHUNK_SIZE - 1) chunk->LightChangedBorders |= 1 << 0;
+		if (x == 0) chunk->LightChangedBorders |= 1 << 1;
+		if (y == CHUNK_SIZE - 1) chunk->LightChangedBorders |= 1 << 2;
+		if (y == 0) chunk->LightChangedBorders |= 1 << 3;
+		if (z == CHUNK_SIZE - 1) chunk->LightChangedBorders |= 1 << 4;
+		if (z == 0) chunk->LightChangedBorders |= 1 << 5;
+	}
+
+	inline void setLevel(Worker& worker, Chunk* chunk, uint32_t cell, bool sky, uint8_t level)
+	{
+		uint8_t light = chunk->Light[cell];
+		setLight(worker, chunk, cell, sky ? static_cast<uint8_t>((level << 4) | BlockLight(light)) : static_cast<uint8_t>((light & 0xF0) | level));
+	}
+
+	//into the queue of the worker the entry's chunk belongs to, right away if that's worker, otherwise through its outbox
+	inline void send(uint32_t worker, const Entry& entry)
+	{
+		uint32_t target = owner(entry.Target);
+		if (target != worker) workers[worker].outbox[target].push_back(entry);
+		else if ((entry.Flags & KIND) >= REMOVED) workers[worker].removals.push_back(entry);
+		else workers[worker].additions.push_back(entry);
+	}
+
+	//rounds of every worker emptying its queue, then handing over its outboxes, until nothing is left
+	void runPhase(bool removal)
+	{
+		uint32_t workerCount = static_cast<uint32_t>(workers.size());
+		auto drain = [&](uint32_t worker, uint32_t) {
+			if (removal) drainRemovals(worker);
+			else drainAdditions(worker);
+		};
+
+		while (true)
+		{
+			size_t queued = 0;
+			for (Worker& worker : workers) queued += removal ? worker.removals.size() : worker.additions.size();
+			if (queued == 0) return;
+
+			if (threadPool != nullptr && workerCount > 1 && queued >= PARALLEL_MIN_ENTRIES) threadPool->ParallelFor(workerCount, drain);
+			else for (uint32_t worker = 0; worker < workerCount; ++worker) drain(worker, 0);
+
+			for (uint32_t from = 0; from < workerCount; ++from)
+				for (uint32_t to = 0; to < workerCount; ++to)
+				{
+					std::vector<Entry>& outbox = workers[from].outbox[to];
+					for (const Entry& entry : outbox) send(to, entry);
+					outbox.clear();
+				}
+		}
+	}
+
+	//darkness spreads to the cells that were lit less than what was taken away (or are under a column of full sky light
+	//that was), those lit as much or more have another source and light the cleared cells again in the additions
+	void drainRemovals(uint32_t index)
+	{
+		Worker& worker = workers[index];
+		for (size_t i = 0; i < worker.removals.size(); ++i)
+		{
+			Entry entry = worker.removals[i];
+			bool sky = entry.Flags & SKY;
+
+			if ((entry.Flags & KIND) == REMOVED)
+			{
+				for (uint32_t face = 0; face < 6; ++face)
+				{
+					uint32_t next;
+					Chunk* neighbour = step(entry.Target, entry.Cell, face, next);
+					if (neighbour != nullptr) send(index, { neighbour, static_cast<uint16_t>(next), entry.Level, static_cast<uint8_t>(CHECK | (entry.Flags & SKY) | (face == DOWN ? FROM_ABOVE : 0)) });
+					else if (sky) worker.additions.push_back({ entry.Target, entry.Cell, openSkyLevel(face), OFFER | SKY });
+				}
+				continue;
+			}
+
+			const GridVoxel& voxel = entry.Target->Voxels[entry.Cell];
+			uint8_t light = entry.Target->Light[entry.Cell];
+			uint8_t level = sky ? SkyLight(light) : BlockLight(light);
+			if (level == 0) continue;
+
+			if (!sky && voxel.Solid) //an emitter, it lights itself
+			{
+				worker.additions.push_back({ entry.Target, entry.Cell, 0, ADD });
+				continue;
+			}
+
+			bool column = sky && (entry.Flags & FROM_ABOVE) && entry.Level == MAX_LIGHT && level == MAX_LIGHT;
+			if (level < entry.Level || column)
+			{
+				setLevel(worker, entry.Target, entry.Cell, sky, 0);
+				worker.removals.push_back({ entry.Target, entry.Cell, level, static_cast<uint8_t>(REMOVED | (entry.Flags & SKY)) });
+			}
+			else worker.additions.push_back({ entry.Target, entry.Cell, 0, static_cast<uint8_t>(ADD | (entry.Flags & SKY)) });
+		}
+		worker.removals.clear();
+	}
+
+	void drainAdditions(uint32_t index)
+	{
+		Worker& worker = workers[index];
+		for (size_t i = 0; i < worker.additions.size(); ++i)
+		{
+			Entry entry = worker.additions[i];
+			bool sky = entry.Flags & SKY;
+			uint8_t light = entry.Target->Light[entry.Cell];
+			uint8_t level = sky ? SkyLight(light) : BlockLight(light);
+
+			if ((entry.Flags & KIND) == OFFER)
+			{
+				if (entry.Target->Voxels[entry.Cell].Solid || level >= entry.Level) continue;
+				level = entry.Level;
+				setLevel(worker, entry.Target, entry.Cell, sky, level);
+			}
+			if (level == 0) continue;
+
+			for (uint32_t face = 0; face < 6; ++face)
+			{
+				uint8_t nextLevel = spreadLevel(level, sky, face);
+				if (nextLevel == 0) continue;
+
+				uint32_t next;
+				Chunk* neighbour = step(entry.Target, entry.Cell, face, next);
+				if (neighbour != nullptr) send(index, { neighbour, static_cast<uint16_t>(next), nextLevel, static_cast<uint8_t>(OFFER | (entry.Flags & SKY)) }); //open sky never changes
+			}
+		}
+		worker.additions.clear();
+	}
+};
@@ -2,8 +2,40 @@
 
 #include "Components/TransformComponent.h"
 #include "Components/VoxelModel.h"
-#include "Voxel.h"
+#include "Components/CubeGeometry.h"
+#include "Components/MeshComponent.h"
+#include "Components/RenderComponent.h"
+#include "TransformBatch.h"
+#include "Chunk.h"
+#include "ChunkMap.h"
+#include "ChunkMesher.h"
+#include "ChunkVisibility.h"
+#include "LightEngine.h"
+#include "TerrainGenerator.h"
+#include "src/ThreadPool.h"
 #include "src/vulkanHandlers/DeviceHandler.h"
+#include "src/vulkanHandlers/BufferHelpers.h"
+#include "src/vulkanHandlers/ChunkBuffers.h"
+#include "src/vulkanHandlers/GpuChunkMesher.h"
+#include "src/vulkanHandlers/GpuTerrainGenerator.h"
+#include "src/vulkanHandlers/DeletionQueueHandler.h"
+#include "vendor/entt.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+
+//a contiguous slice of the index buffer, drawn with one vkCmdDrawIndexed (or one command of an indirect draw)
+//its indices are VertexIndex, relative to vertexOffset
+struct DrawRange
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	int32_t vertexOffset = 0;
+};
 
 struct RendererInfo
 {
@@ -11,134 +43,874 @@ struct RendererInfo
 	DeviceHandler* deviceHandler;
 	CommandBuffersHandler* commandBuffersHandler;
 
-	VkBuffer vertexBuffer;
-	VkDeviceMemory vertexBufferMemory;
+	//the AddVoxel voxels, VK_NULL_HANDLE if there are none
+	VkBuffer vertexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
 
-	VkBuffer indexBuffer;
-	VkDeviceMemory indexBufferMemory;
+	VkBuffer indexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory indexBufferMemory = VK_NULL_HANDLE;
 
 	uint32_t numIndices = 0;
+
+	//the scene split into groups that can be recorded on different threads
+	std::vector<DrawRange> drawRanges;
+
+	//the grid's chunks, one draw each, all from the same pair of buffers (see ChunkBuffers)
+	VkBuffer chunkVertexBuffer = VK_NULL_HANDLE;
+	VkBuffer chunkIndexBuffer = VK_NULL_HANDLE;
+	std::vector<DrawRange> chunkDrawRanges;
+
+	uint64_t version = 0; //bumped whenever the buffers or draw ranges change, so recorded command buffers know they are stale
+	uint64_t transformVersion = 0; //bumped whenever an object's model matrix changes
 };
 
 class Scene
 {
-	std::unordered_map<uint32_t, Voxel> voxels;
-	uint32_t idCount = 0;
+	//every voxel is an entity with a TransformComponent, MeshComponent and RenderComponent, which are kept in one owning
+	//group so they sit in parallel arrays in the same order, render extraction walks them front to back
+	entt::registry registry;
 	RendererInfo ri;
 
+	//dynamic voxels get their own model matrix instead of being baked, object 0 is the identity used by static ones
+	std::vector<glm::mat4> objectMatrices;
+	std::vector<uint32_t> freeObjects; //indices of removed dynamic voxels, reused before growing objectMatrices
+	std::vector<uint32_t> removedObjects; //still referenced by the baked geometry, freed by the next FinishScene
+
+	//scratch for UpdateTransforms, kept so moving objects every frame doesn't allocate
+	std::vector<TransformComponent> dirtyTransforms;
+	std::vector<uint32_t> dirtyObjects;
+
+	ThreadPool* threadPool; //splits baking across workers, nullptr bakes on the calling thread
+
+	//the voxel cube's vertex positions as separate x/y/z arrays, so TransformBatch::TransformPoints can load them straight into registers
+	static constexpr auto cubeX = CubeGeometry::Positions(0, VOXEL_SIZE);
+	static constexpr auto cubeY = CubeGeometry::Positions(1, VOXEL_SIZE);
+	static constexpr auto cubeZ = CubeGeometry::Positions(2, VOXEL_SIZE);
+
+	//the editable voxel grid, chunks are created on the first edit inside them and evicted once they are empty (and lit like
+	//open sky, see LightEngine) again
+	ChunkMap chunks;
+	LightEngine lighting;
+	std::vector<Chunk*> dirtyChunks;
+	ChunkBuffers* chunkBuffers = nullptr; //created by the first UpdateChunks, scenes without a device never need it
+	uint32_t lastRemeshCount = 0;
+
+	//remeshing output per dirty chunk, kept so edits don't reallocate every frame
+	std::vector<std::vector<Vertex>> meshVertices;
+	std::vector<std::vector<VertexIndex>> meshIndices;
+	std::vector<std::array<uint32_t, 6>> meshFaceCounts;
+
+	//the compute shader meshing backend, see SetGpuMeshing. The GPU only needs where each row's faces go from the CPU
+	bool gpuMeshing = false;
+	GpuChunkMesher* gpuMesher = nullptr; //created by the first UpdateChunks after GPU meshing is turned on
+	std::vector<std::array<uint32_t, 6 * CHUNK_SIZE * CHUNK_SIZE>> meshRowOffsets;
+	std::vector<uint32_t> meshFaces;
+	std::vector<uint32_t*> stagedCells;
+	std::vector<uint8_t> filledOnGpu; //see GpuTerrainGenerator::CanFill
+
+	//generating terrain with a compute shader, see SetGpuTerrain
+	bool gpuTerrain = false;
+	GpuTerrainGenerator* gpuGenerator = nullptr; //created by the first GenerateTerrain after it's turned on
+
+	//the chunk draw ranges only change when a mesh does or the viewer moves into another chunk, see CullChunks
+	bool chunkFaceCulling = true;
+	bool chunkCaveCulling = true;
+	ChunkVisibility visibility;
+	bool chunkRangesDirty = false;
+	glm::ivec3 viewerMinChunk = glm::ivec3(0), viewerMaxChunk = glm::ivec3(0);
+
+	inline auto voxelGroup() { return registry.group<TransformComponent, MeshComponent, RenderComponent>(); }
+
+	//the voxel group's storages, resolved once per WriteGeometry for the bake tasks
+	struct BakeSource
+	{
+		entt::storage_for_t<TransformComponent>* transforms;
+		entt::storage_for_t<MeshComponent>* meshes;
+		entt::storage_for_t<RenderComponent>* renders;
+		uint32_t size;
+	};
+
 public:
-	Scene(DeviceHandler* _dh, CommandBuffersHandler* _cbh)
+	static const uint32_t VOXELS_PER_DRAW = 2048; //voxels are grouped into draws by index order, small enough for 16 bit indices
+	static const uint32_t VOXELS_PER_BAKE_TASK = 4096;
+	static constexpr float VIEWER_MARGIN = VOXEL_SIZE * CHUNK_SIZE; //well over what the camera moves in a frame, see CullChunks
+	static_assert(VOXELS_PER_DRAW * VoxelModel::VERTICIES_PER_VOXEL <= MAX_VERTICES_PER_DRAW, "A draw's vertices must be reachable with 16 bit indices");
+
+	Scene(DeviceHandler* _dh, CommandBuffersHandler* _cbh, ThreadPool* _threadPool = nullptr) : threadPool(_threadPool), lighting(chunks, _threadPool)
 	{
 		ri.deviceHandler = _dh;
 		ri.commandBuffersHandler = _cbh;
+
+		objectMatrices.emplace_back(1.0f);
+		voxelGroup(); //creating the group up front keeps the pools sorted as entities are added
 	}
 
 	RendererInfo& GetRenderInfo() { return ri; }
+	inline entt::registry& GetRegistry() { return registry; }
 
-	void AddVoxel(const TransformComponent& T, const glm::vec3& color = glm::vec3(1.0f))
+	//material is a texture array layer + 1, see MATERIAL_TEXTURE_PATHS
+	//dynamic voxels can be moved with SetTransform after FinishScene, static ones are baked into world space
+	entt::entity AddVoxel(const TransformComponent& T, const glm::vec3& color = glm::vec3(1.0f), uint32_t material = MATERIAL_NONE, bool dynamic = false)
 	{
-		Voxel v(T, glm::vec3(0.1f), color);
-		voxels[idCount] = v;
-		++idCount;
+		entt::entity entity = registry.create();
+		registry.emplace<TransformComponent>(entity, T);
+		registry.emplace<MeshComponent>(entity, color, material);
+
+		uint32_t objectIndex = 0;
+		if (dynamic)
+		{
+			if (!freeObjects.empty())
+			{
+				objectIndex = freeObjects.back();
+				freeObjects.pop_back();
+			}
+			else
+			{
+				objectIndex = static_cast<uint32_t>(objectMatrices.size());
+				objectMatrices.emplace_back(1.0f);
+			}
+			registry.emplace<TransformDirtyTag>(entity);
+		}
+		registry.emplace<RenderComponent>(entity, objectIndex);
+
+		return entity;
 	}
 
-	void FinishScene()
+	//takes effect the next time FinishScene is called
+	void RemoveVoxel(entt::entity entity)
 	{
-		createVertexBuffer();
-		createIndexBuffer();
+		if (!registry.valid(entity)) throw std::runtime_error("No voxel with entity ID " + std::to_string(entt::to_integral(entity)) + '\n');
+
+		uint32_t objectIndex = registry.get<RenderComponent>(entity).ObjectIndex;
+		if (objectIndex != 0) removedObjects.push_back(objectIndex); //reusing it now would move the removed voxel until the rebake
+		registry.destroy(entity);
 	}
 
-	void TerminateScene()
+	//only a matrix write for dynamic voxels, static ones move the next time FinishScene is called
+	void SetTransform(entt::entity entity, const TransformComponent& T)
 	{
-		VkDevice& device = ri.deviceHandler->getLogicalDevice();
-		vkDestroyBuffer(device, ri.vertexBuffer, nullptr);
-		vkFreeMemory(device, ri.vertexBufferMemory, nullptr);
-		vkDestroyBuffer(device, ri.indexBuffer, nullptr);
-		vkFreeMemory(device, ri.indexBufferMemory, nullptr);
+		if (!registry.valid(entity)) throw std::runtime_error("No voxel with entity ID " + std::to_string(entt::to_integral(entity)) + '\n');
+
+		registry.replace<TransformComponent>(entity, T);
+		if (registry.get<RenderComponent>(entity).ObjectIndex != 0) registry.emplace_or_replace<TransformDirtyTag>(entity);
 	}
 
-private:
-	void createVertexBuffer() 
+	//transform update system: recomputes the model matrices of dynamic voxels moved since the last call, the renderer calls this every frame
+	void UpdateTransforms()
 	{
-		VkDeviceSize bufferSize = sizeof(Vertex) * VoxelModel::VERTICIES_PER_VOXEL * voxels.size();
+		auto dirty = registry.view<const TransformComponent, const RenderComponent, TransformDirtyTag>();
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-		BufferHelpers::CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory, ri.deviceHandler);
+		dirtyTransforms.clear();
+		dirtyObjects.clear();
+		for (auto [entity, transform, render] : dirty.each())
+		{
+			dirtyTransforms.push_back(transform);
+			dirtyObjects.push_back(render.ObjectIndex);
+		}
 
-		VkDevice& device = ri.deviceHandler->getLogicalDevice();
+		if (dirtyObjects.empty()) return;
 
-		void* data;
-		vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-		
-		int voxelOn = 0;
+		TransformBatch::ComputeMatrices(dirtyTransforms.data(), dirtyTransforms.size(), objectMatrices.data(), dirtyObjects.data());
+		registry.clear<TransformDirtyTag>();
+		++ri.transformVersion;
+	}
+
+	//grid edits only touch the chunk's voxels, the chunk (and the chunks around it next to the cell) are relit and remeshed
+	//by the next UpdateChunks, which the renderer calls every frame, so they can be made before or after FinishScene
+	//emission is the block light the voxel gives off, 0 to LightEngine::MAX_LIGHT
+	void SetVoxel(const glm::ivec3& cell, const glm::vec3& color, uint32_t material = MATERIAL_NONE, uint32_t emission = 0)
+	{
+		FillBox(cell, cell, color, material, emission);
+	}
+
+	void RemoveVoxel(const glm::ivec3& cell)
+	{
+		FillBox(cell, cell, GridVoxel());
+	}
 
-		for (auto& IDVoxelPair : voxels)
+	//min and max are inclusive
+	void FillBox(const glm::ivec3& min, const glm::ivec3& max, const glm::vec3& color, uint32_t material = MATERIAL_NONE, uint32_t emission = 0)
+	{
+		GridVoxel voxel;
+		voxel.Color = PackColor(color);
+		voxel.Material = static_cast<uint16_t>(material);
+		voxel.Solid = true;
+		voxel.Emission = static_cast<uint8_t>(std::min<uint32_t>(emission, LightEngine::MAX_LIGHT));
+		FillBox(min, max, voxel);
+	}
+
+	//a non solid voxel clears the box
+	void FillBox(const glm::ivec3& min, const glm::ivec3& max, const GridVoxel& voxel)
+	{
+		glm::ivec3 minChunk = CellToChunk(min), maxChunk = CellToChunk(max);
+
+		for (int cy = minChunk.y; cy <= maxChunk.y; ++cy)
 		{
-			Vertex* writeStart = (Vertex*)data + VoxelModel::VERTICIES_PER_VOXEL * voxelOn;
-			Vertex* readStart = IDVoxelPair.second.VoxelModel.getVertexData();
-			for (Vertex *writePtr = writeStart, *readPtr = readStart;
-				 writePtr < writeStart + VoxelModel::VERTICIES_PER_VOXEL && readPtr < readStart + VoxelModel::VERTICIES_PER_VOXEL;
-				++writePtr, ++readPtr)
+			for (int cz = minChunk.z; cz <= maxChunk.z; ++cz)
 			{
-				*writePtr = *readPtr;
+				for (int cx = minChunk.x; cx <= maxChunk.x; ++cx)
+				{
+					glm::ivec3 chunkPosition(cx, cy, cz);
+					glm::ivec3 chunkMin = chunkPosition * CHUNK_SIZE;
+					glm::ivec3 localMin = glm::max(min, chunkMin) - chunkMin;
+					glm::ivec3 localMax = glm::min(max, chunkMin + glm::ivec3(CHUNK_SIZE - 1)) - chunkMin;
+
+					Chunk* chunk = getChunk(chunkPosition, voxel.Solid);
+					if (chunk == nullptr) continue; //clearing a chunk that doesn't exist
+					chunk->GpuTerrain = GpuTerrainGenerator::NO_TERRAIN; //its voxels aren't the generator's anymore
+
+					for (int y = localMin.y; y <= localMax.y; ++y)
+						for (int z = localMin.z; z <= localMax.z; ++z)
+							for (int x = localMin.x; x <= localMax.x; ++x)
+							{
+								uint32_t index = Chunk::Index(x, y, z);
+								GridVoxel before = chunk->Voxels[index];
+								if (before.Solid && !voxel.Solid) --chunk->SolidCount;
+								else if (!before.Solid && voxel.Solid) ++chunk->SolidCount;
+								chunk->Voxels[index] = voxel;
+								lighting.CellChanged(chunk, index, before);
+							}
+
+					markDirty(chunk);
+
+					//faces on the chunk's border are culled against the neighbour's cells, and vertices along its edges and
+					//corners are occluded by the cells of the chunks diagonal to it, so those the box touches are remeshed too
+					for (int dy = -1; dy <= 1; ++dy)
+						for (int dz = -1; dz <= 1; ++dz)
+							for (int dx = -1; dx <= 1; ++dx)
+							{
+								glm::ivec3 offset(dx, dy, dz);
+								bool touches = offset != glm::ivec3(0);
+								for (int axis = 0; axis < 3; ++axis)
+								{
+									if (offset[axis] > 0 && localMax[axis] != CHUNK_SIZE - 1) touches = false;
+									if (offset[axis] < 0 && localMin[axis] != 0) touches = false;
+								}
+								if (!touches) continue;
+
+								Chunk* neighbour = chunks.Find(chunkPosition + offset);
+								if (neighbour != nullptr) markDirty(neighbour);
+							}
+				}
+			}
+		}
+	}
+
+	//generates the chunks from minChunk to maxChunk (inclusive) that don't exist yet, ones that do keep their voxels
+	//a column of chunks shares its heights, which are evaluated per column and the chunks filled per chunk, both across the
+	//thread pool. Chunks above the surface stay open sky and aren't created. Lit and meshed by the next UpdateChunks
+	//returns the number of chunks generated
+	uint32_t GenerateTerrain(const TerrainGenerator& generator, const glm::ivec3& minChunk, const glm::ivec3& maxChunk)
+	{
+		glm::ivec3 size = maxChunk - minChunk + 1;
+		if (size.x <= 0 || size.y <= 0 || size.z <= 0) return 0;
+
+		uint32_t columnCount = static_cast<uint32_t>(size.x * size.z);
+		std::vector<int32_t> heights((size_t)columnCount * CHUNK_SIZE * CHUNK_SIZE);
+		//reading the heights back waits for the GPU, which only pays off when the GPU meshes too and fills the chunks' cells
+		//itself instead of them being uploaded, otherwise the CPU computes them without the stall
+		bool onGpu = gpuTerrain && gpuMeshing;
+		if (onGpu && gpuGenerator == nullptr) createGpuGenerator();
+
+		//the GPU's heights are the same, the CPU's copy of the chunks is filled from them either way
+		uint32_t terrain = GpuTerrainGenerator::NO_TERRAIN;
+		if (onGpu && gpuGenerator != nullptr)
+		{
+			terrain = gpuGenerator->AddTerrain(generator);
+			gpuGenerator->ColumnHeights(terrain, minChunk, static_cast<uint32_t>(size.x), columnCount, heights.data());
+		}
+		else
+		{
+			auto columnHeights = [&](uint32_t column, uint32_t) {
+				int cx = minChunk.x + static_cast<int>(column % size.x), cz = minChunk.z + static_cast<int>(column / size.x);
+				generator.ColumnHeights(cx * CHUNK_SIZE, cz * CHUNK_SIZE, &heights[(size_t)column * CHUNK_SIZE * CHUNK_SIZE]);
+			};
+			if (threadPool != nullptr && columnCount > 1) threadPool->ParallelFor(columnCount, columnHeights);
+			else for (uint32_t column = 0; column < columnCount; ++column) columnHeights(column, 0);
+		}
+
+		//only this thread may create chunks
+		std::vector<Chunk*> generated;
+		std::vector<uint32_t> generatedColumns;
+		for (uint32_t column = 0; column < columnCount; ++column)
+		{
+			const int32_t* first = &heights[(size_t)column * CHUNK_SIZE * CHUNK_SIZE];
+			int32_t top = *std::max_element(first, first + CHUNK_SIZE * CHUNK_SIZE);
 
-				glm::vec4 homogenousPos = glm::vec4(readPtr->pos, 1.0f);
-				homogenousPos = IDVoxelPair.second.Transform.GetTransformMatrix() * homogenousPos;
+			for (int cy = minChunk.y; cy <= maxChunk.y && cy * CHUNK_SIZE <= top; ++cy)
+			{
+				glm::ivec3 position(minChunk.x + static_cast<int>(column % size.x), cy, minChunk.z + static_cast<int>(column / size.x));
+				if (chunks.Find(position) != nullptr) continue;
 
-				writePtr->pos.x = homogenousPos.x;
-				writePtr->pos.y = homogenousPos.y;
-				writePtr->pos.z = homogenousPos.z;
+				generated.push_back(chunks.GetOrCreate(position));
+				generated.back()->GpuTerrain = terrain;
+				generatedColumns.push_back(column);
 			}
+		}
 
-			++voxelOn;
+		uint32_t count = static_cast<uint32_t>(generated.size());
+		auto fill = [&](uint32_t task, uint32_t) { generator.FillChunk(*generated[task], &heights[(size_t)generatedColumns[task] * CHUNK_SIZE * CHUNK_SIZE]); };
+		if (threadPool != nullptr && count > 1) threadPool->ParallelFor(count, fill);
+		else for (uint32_t task = 0; task < count; ++task) fill(task, 0);
+
+		lighting.ChunksGenerated(generated);
+
+		//the chunks that were there already are remeshed where they touch the new ones, like after an edit on their border
+		for (Chunk* chunk : generated)
+		{
+			markDirty(chunk);
+			for (int dy = -1; dy <= 1; ++dy)
+				for (int dz = -1; dz <= 1; ++dz)
+					for (int dx = -1; dx <= 1; ++dx)
+					{
+						Chunk* neighbour = chunks.Find(chunk->Position + glm::ivec3(dx, dy, dz));
+						if (neighbour != nullptr) markDirty(neighbour);
+					}
 		}
 
-		vkUnmapMemory(device, stagingBufferMemory);
+		return count;
+	}
 
-		BufferHelpers::CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ri.vertexBuffer, ri.vertexBufferMemory, ri.deviceHandler);
+	bool IsSolid(const glm::ivec3& cell)
+	{
+		Chunk* chunk = chunks.Find(CellToChunk(cell));
+		if (chunk == nullptr) return false;
 
-		BufferHelpers::CopyBuffer(stagingBuffer, ri.vertexBuffer, bufferSize, ri.commandBuffersHandler);
+		glm::ivec3 local = CellToLocal(cell);
+		return chunk->At(local.x, local.y, local.z).Solid;
+	}
 
-		vkDestroyBuffer(device, stagingBuffer, nullptr);
-		vkFreeMemory(device, stagingBufferMemory, nullptr);
+	//as of the last UpdateChunks, packed like Chunk::Light
+	uint8_t GetLight(const glm::ivec3& cell)
+	{
+		Chunk* chunk = chunks.Find(CellToChunk(cell));
+		if (chunk == nullptr) return LightEngine::OPEN_SKY;
+
+		glm::ivec3 local = CellToLocal(cell);
+		return chunk->Light[Chunk::Index(local.x, local.y, local.z)];
 	}
 
-	void createIndexBuffer() {
-		VkDeviceSize bufferSize = sizeof(uint32_t) * VoxelModel::INDICES_PER_VOXEL * voxels.size();
+	inline size_t GetChunkCount() { return chunks.getCount(); }
+	inline uint32_t GetLastRemeshCount() { return lastRemeshCount; }
+	inline bool AreChunksWrittenDirectly() { return chunkBuffers != nullptr && chunkBuffers->isWrittenDirectly(); }
+
+	//meshes chunks with a compute shader (GpuChunkMesher) instead of on the CPU, the meshes are the same either way
+	//turning it on remeshes every chunk, so the GPU has all of their cells. It's turned back off (and the CPU meshes) if
+	//the device can't, see UpdateChunks
+	inline bool GetGpuMeshing() { return gpuMeshing; }
+	void SetGpuMeshing(bool enabled)
+	{
+		if (enabled && !gpuMeshing) chunks.ForEach([&](Chunk* chunk) { markDirty(chunk); });
+		gpuMeshing = enabled;
+	}
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-		BufferHelpers::CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory, ri.deviceHandler);
+	//generates terrain (see GenerateTerrain) with a compute shader (GpuTerrainGenerator) instead of on the CPU, the terrain
+	//is the same either way. Only takes effect with GPU meshing too, the generated chunks' cells are then written on the GPU
+	//rather than uploaded. Falls back to the CPU if the device can't
+	inline bool GetGpuTerrain() { return gpuTerrain; }
+	inline void SetGpuTerrain(bool enabled) { gpuTerrain = enabled; }
 
-		VkDevice& device = ri.deviceHandler->getLogicalDevice();
+	//relights and remeshes the chunks edited since the last call (both split across the thread pool) and stages their uploads
+	//call once per frame, after the frame's fence has signaled and before recording it, then RecordChunkUploads while recording
+	void UpdateChunks(uint32_t currentFrame, DeletionQueueHandler* deletionQueue)
+	{
+		//the faces on a chunk's border are lit by the cells of the neighbour in front of them
+		lighting.Propagate([&](Chunk* chunk, uint8_t borders) {
+			markDirty(chunk);
+			for (uint32_t face = 0; face < 6; ++face)
+			{
+				if (!(borders & (1 << face))) continue;
+				Chunk* neighbour = chunks.Find(chunk->Position + glm::ivec3(FACE_DIRECTIONS[face][0], FACE_DIRECTIONS[face][1], FACE_DIRECTIONS[face][2]));
+				if (neighbour != nullptr) markDirty(neighbour);
+			}
+		});
+
+		lastRemeshCount = static_cast<uint32_t>(dirtyChunks.size());
+		if (dirtyChunks.empty()) return;
+
+		if (chunkBuffers == nullptr) chunkBuffers = new ChunkBuffers(ri.deviceHandler, deletionQueue);
+		if (gpuMeshing && gpuMesher == nullptr) createGpuMesher(deletionQueue);
+
+		uint32_t count = static_cast<uint32_t>(dirtyChunks.size());
+		if (gpuMeshing && updateChunksOnGpu(currentFrame)) return;
+
+		if (meshVertices.size() < count)
+		{
+			meshVertices.resize(count);
+			meshIndices.resize(count);
+			meshFaceCounts.resize(count);
+		}
+
+		auto remesh = [&](uint32_t task, uint32_t) {
+			Chunk* chunk = dirtyChunks[task];
+			const Chunk* neighbourhood[27];
+			chunks.GetNeighbourhood(chunk->Position, neighbourhood);
+			ChunkMesher::MeshChunk(*chunk, neighbourhood, meshVertices[task], meshIndices[task], meshFaceCounts[task]);
+			chunk->Connections = ChunkMesher::FaceConnections(*chunk); //only its own voxels, no other task touches them
+		};
+
+		if (threadPool != nullptr && count > 1) threadPool->ParallelFor(count, remesh);
+		else for (uint32_t task = 0; task < count; ++task) remesh(task, 0);
+
+		VkDeviceSize vertexBytes = 0, indexBytes = 0;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			vertexBytes += sizeof(Vertex) * meshVertices[i].size();
+			indexBytes += sizeof(VertexIndex) * meshIndices[i].size();
+		}
+		chunkBuffers->BeginUploads(currentFrame, vertexBytes, indexBytes);
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			Chunk* chunk = dirtyChunks[i];
+			ChunkMesh& mesh = chunk->Mesh;
+			chunkBuffers->Free(mesh.vertexOffset, mesh.vertexCount, mesh.firstIndex, mesh.indexCount);
+
+			mesh.vertexCount = static_cast<uint32_t>(meshVertices[i].size());
+			mesh.indexCount = static_cast<uint32_t>(meshIndices[i].size());
+			mesh.faceIndexCounts = meshFaceCounts[i];
+			chunkBuffers->Upload(currentFrame, meshVertices[i].data(), mesh.vertexCount, meshIndices[i].data(), mesh.indexCount, mesh.vertexOffset, mesh.firstIndex);
+
+			chunk->Dirty = false;
+			if (LightEngine::IsOpenSky(*chunk)) removeChunk(chunk); //empty, its mesh is freed above
+		}
+		finishChunkUpdate();
+	}
+
+	//rebuilds the chunk draw ranges if a mesh changed since the last call, or if the viewer moved into another chunk
+	//call once per frame after UpdateChunks, with the camera's position
+	//chunks that can't be seen from the viewer's chunk (ChunkVisibility) are left out, and of the rest only the face
+	//groups that can face the viewer are drawn. Both only depend on the viewer's chunk, so this is only redone when it
+	//changes rather than every frame (a recorded frame stays valid as long as the ranges do)
+	//the camera may still move before the frame is drawn (input is sampled after this), so the viewer is taken as
+	//anywhere within VIEWER_MARGIN of viewer
+	void CullChunks(const glm::vec3& viewer)
+	{
+		glm::ivec3 minChunk = WorldToChunk(viewer - VIEWER_MARGIN), maxChunk = WorldToChunk(viewer + VIEWER_MARGIN);
+		bool moved = minChunk != viewerMinChunk || maxChunk != viewerMaxChunk;
+		if (!chunkRangesDirty && (!moved || !(chunkFaceCulling || chunkCaveCulling))) return;
+
+		viewerMinChunk = minChunk;
+		viewerMaxChunk = maxChunk;
+		chunkRangesDirty = false;
+
+		if (chunkCaveCulling) visibility.Update(chunks, viewerMinChunk, viewerMaxChunk);
+
+		ri.chunkDrawRanges.clear();
+		chunks.ForEach([&](Chunk* chunk) {
+			if (chunkCaveCulling && !visibility.IsVisible(chunk->Position)) return;
+			addChunkDrawRanges(chunk->Mesh, chunkFaceCulling ? VisibleFaceMask(chunk->Position, viewerMinChunk, viewerMaxChunk) : 0x3F);
+		});
+		++ri.version;
+	}
+
+	inline bool GetChunkFaceCulling() { return chunkFaceCulling; }
+	void SetChunkFaceCulling(bool culling) { chunkFaceCulling = culling; chunkRangesDirty = true; }
+	inline bool GetChunkCaveCulling() { return chunkCaveCulling; }
+	void SetChunkCaveCulling(bool culling) { chunkCaveCulling = culling; chunkRangesDirty = true; }
+	inline uint32_t GetHiddenChunkCount() { return chunkCaveCulling ? visibility.getHiddenCount() : 0; }
+	inline size_t GetChunkDrawCount() { return ri.chunkDrawRanges.size(); }
+
+	//outside of a render pass, before the scene is drawn, also meshes the chunks that are meshed on the GPU
+	void RecordChunkUploads(VkCommandBuffer commandBuffer, uint32_t currentFrame)
+	{
+		if (chunkBuffers != nullptr) chunkBuffers->RecordCopies(commandBuffer, currentFrame);
+		if (gpuMesher == nullptr) return;
+
+		//fills are only queued while GPU terrain is on, ones this frame's UpdateChunks queued are the only copy of those cells
+		std::function<void(VkCommandBuffer, VkBuffer)> writeCells;
+		if (gpuGenerator != nullptr && gpuGenerator->hasFills(currentFrame))
+			writeCells = [&](VkCommandBuffer, VkBuffer cellBuffer) { gpuGenerator->RecordFills(commandBuffer, currentFrame, cellBuffer); };
+		gpuMesher->RecordDispatch(commandBuffer, currentFrame, chunkBuffers->getVertexBuffer(), chunkBuffers->getIndexBuffer(), writeCells);
+	}
+
+	inline size_t GetVoxelCount() { return voxelGroup().size(); }
+	inline uint32_t GetObjectCount() { return static_cast<uint32_t>(objectMatrices.size()); }
+	inline const glm::mat4* GetObjectMatrices() { return objectMatrices.data(); }
+
+	//render extraction, the CPU side of FinishScene: write every voxel's vertices (transformed if static, tagged with its
+	//object if dynamic) and rebased indices into vertices / indices in group order, returns the number of indices written
+	//the voxels are split into tasks over the thread pool (if the scene has one), each writing its own range of both arrays
+	//indices restart from 0 every VOXELS_PER_DRAW voxels, each group is drawn with its first vertex as the base vertex (see createBuffers)
+	//vertices must hold GetVoxelCount() * VERTICIES_PER_VOXEL, indices GetVoxelCount() * INDICES_PER_VOXEL, no device is needed
+	uint32_t WriteGeometry(Vertex* vertices, VertexIndex* indices)
+	{
+		//the group is looked up here, the registry isn't safe to touch from the workers, they only read its storages
+		auto group = voxelGroup();
+		uint32_t voxelCount = static_cast<uint32_t>(group.size());
+		BakeSource source{ group.storage<TransformComponent>(), group.storage<MeshComponent>(), group.storage<RenderComponent>(), voxelCount };
+
+		uint32_t taskCount = (voxelCount + VOXELS_PER_BAKE_TASK - 1) / VOXELS_PER_BAKE_TASK;
+		auto bake = [&](uint32_t task, uint32_t) {
+			uint32_t first = task * VOXELS_PER_BAKE_TASK;
+			bakeVoxels(source, first, std::min(first + VOXELS_PER_BAKE_TASK, voxelCount), vertices, indices);
+		};
+
+		if (threadPool != nullptr && taskCount > 1) threadPool->ParallelFor(taskCount, bake);
+		else for (uint32_t task = 0; task < taskCount; ++task) bake(task, 0);
+
+		return voxelCount * VoxelModel::INDICES_PER_VOXEL;
+	}
+
+	//once frames are in flight, pass the renderer's deletion queue so the buffers they draw from outlive them
+	void FinishScene(DeletionQueueHandler* deletionQueue = nullptr)
+	{
+		UpdateTransforms();
+		createBuffers(deletionQueue);
+		++ri.version;
+
+		//nothing drawn from now on references the removed voxels' objects
+		freeObjects.insert(freeObjects.end(), removedObjects.begin(), removedObjects.end());
+		removedObjects.clear();
+	}
+
+	void TerminateScene()
+	{
+		destroyBuffers(nullptr);
+
+		delete chunkBuffers; //after the deletion queue has been flushed, it may still hold frees into chunkBuffers
+		chunkBuffers = nullptr;
+		delete gpuMesher;
+		gpuMesher = nullptr;
+		delete gpuGenerator;
+		gpuGenerator = nullptr;
+	}
+
+private:
+	Chunk* getChunk(const glm::ivec3& position, bool create)
+	{
+		Chunk* chunk = chunks.Find(position);
+		if (chunk != nullptr || !create) return chunk;
+
+		chunk = chunks.GetOrCreate(position);
+		lighting.ChunkCreated(chunk);
+		return chunk;
+	}
+
+	void removeChunk(Chunk* chunk)
+	{
+		if (chunk->GpuSlot != GpuChunkMesher::NO_SLOT) gpuMesher->FreeSlot(chunk->GpuSlot);
+		chunks.Remove(chunk->Position);
+	}
+
+	void finishChunkUpdate()
+	{
+		dirtyChunks.clear();
+		chunks.Reclaim(); //the remeshing workers are done, nothing else holds on to chunks
+
+		ri.chunkVertexBuffer = chunkBuffers->getVertexBuffer();
+		ri.chunkIndexBuffer = chunkBuffers->getIndexBuffer();
+		chunkRangesDirty = true;
+	}
+
+	void createGpuMesher(DeletionQueueHandler* deletionQueue)
+	{
+		try { gpuMesher = new GpuChunkMesher(ri.deviceHandler, deletionQueue); }
+		catch (const std::runtime_error& e)
+		{
+			std::cerr << "GPU meshing is unavailable, chunks are meshed on the CPU: " << e.what();
+			gpuMeshing = false;
+		}
+	}
+
+	void createGpuGenerator()
+	{
+		try { gpuGenerator = new GpuTerrainGenerator(ri.deviceHandler, ri.commandBuffersHandler); }
+		catch (const std::runtime_error& e)
+		{
+			std::cerr << "GPU terrain generation is unavailable, terrain is generated on the CPU: " << e.what();
+			gpuTerrain = false;
+		}
+	}
 
-		void* data;
-		vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
+	//the GPU half of UpdateChunks: the CPU lays the dirty chunks' faces out (see ChunkMesher::FaceLayout) and packs their
+	//cells across the thread pool, then allocates their meshes and queues a job per chunk for RecordChunkUploads' dispatch
+	//returns false if the device can't hold the chunks or reach the buffers their meshes would go into, without having
+	//touched their meshes, GPU meshing is turned off and the CPU meshes them instead
+	bool updateChunksOnGpu(uint32_t currentFrame)
+	{
+		uint32_t count = static_cast<uint32_t>(dirtyChunks.size());
 
-		int voxelOn = 0;
+		uint32_t newSlots = 0;
+		for (Chunk* chunk : dirtyChunks) if (chunk->GpuSlot == GpuChunkMesher::NO_SLOT) ++newSlots;
+		if (!gpuMesher->canAllocateSlots(newSlots))
+		{
+			std::cerr << "Too many chunks to mesh on the GPU, meshing on the CPU\n";
+			gpuMeshing = false;
+			return false;
+		}
+		for (Chunk* chunk : dirtyChunks) if (chunk->GpuSlot == GpuChunkMesher::NO_SLOT) chunk->GpuSlot = gpuMesher->AllocateSlot();
 
-		for (auto& IDVoxelPair : voxels)
+		if (meshFaces.size() < count)
 		{
-			uint32_t* writeStart = (uint32_t*)data + VoxelModel::INDICES_PER_VOXEL * voxelOn;
-			uint32_t* readStart = IDVoxelPair.second.VoxelModel.getIndicesData();
-			for (uint32_t* writePtr = writeStart, *readPtr = readStart;
-				writePtr < writeStart + VoxelModel::INDICES_PER_VOXEL && readPtr < readStart + VoxelModel::INDICES_PER_VOXEL;
-				++writePtr, ++readPtr)
+			meshRowOffsets.resize(count);
+			meshFaces.resize(count);
+			meshFaceCounts.resize(count);
+			stagedCells.resize(count);
+			filledOnGpu.resize(count);
+		}
+
+		auto layout = [&](uint32_t task, uint32_t) {
+			Chunk* chunk = dirtyChunks[task];
+			const Chunk* neighbourhood[27];
+			chunks.GetNeighbourhood(chunk->Position, neighbourhood);
+			meshFaces[task] = ChunkMesher::FaceLayout(*chunk, neighbourhood, meshRowOffsets[task].data(), meshFaceCounts[task]);
+			chunk->Connections = ChunkMesher::FaceConnections(*chunk);
+			filledOnGpu[task] = gpuTerrain && gpuGenerator != nullptr && GpuTerrainGenerator::CanFill(*chunk);
+		};
+
+		if (threadPool != nullptr && count > 1) threadPool->ParallelFor(count, layout);
+		else for (uint32_t task = 0; task < count; ++task) layout(task, 0);
+
+		//the buffers may grow by the new meshes, they have to stay within what the shader can write
+		uint32_t vertexCount = 0;
+		for (uint32_t i = 0; i < count; ++i) vertexCount += meshFaces[i] * 4;
+		VkDeviceSize vertexBufferSize = chunkBuffers->getVertexBufferSize(), indexBufferSize = chunkBuffers->getIndexBufferSize();
+		VkDeviceSize grownVertexSize = std::max(2 * vertexBufferSize, vertexBufferSize + sizeof(Vertex) * (VkDeviceSize)vertexCount);
+		VkDeviceSize grownIndexSize = std::max(2 * indexBufferSize, indexBufferSize + sizeof(VertexIndex) * (VkDeviceSize)vertexCount * 3 / 2);
+		if (!gpuMesher->canReach(grownVertexSize) || !gpuMesher->canReach(grownIndexSize))
+		{
+			std::cerr << "The chunk meshes outgrew what the GPU mesher can write, meshing on the CPU\n";
+			gpuMeshing = false;
+			return false;
+		}
+
+		chunkBuffers->setWrittenByDevice();
+
+		//the slots of every dirty chunk are updated before any chunk is meshed, neighbours read them too
+		//generated chunks that are still untouched are filled on the GPU, the rest are uploaded
+		gpuMesher->Reserve(currentFrame, count, count);
+		if (gpuTerrain && gpuGenerator != nullptr) gpuGenerator->Reserve(currentFrame, count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			Chunk* chunk = dirtyChunks[i];
+			if (filledOnGpu[i]) gpuGenerator->AddFill(currentFrame, *chunk);
+			else stagedCells[i] = gpuMesher->StageCells(currentFrame, chunk->GpuSlot);
+		}
+
+		auto pack = [&](uint32_t task, uint32_t) {
+			if (!filledOnGpu[task]) GpuChunkMesher::PackCells(*dirtyChunks[task], stagedCells[task]);
+		};
+		if (threadPool != nullptr && count > 1) threadPool->ParallelFor(count, pack);
+		else for (uint32_t task = 0; task < count; ++task) pack(task, 0);
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			Chunk* chunk = dirtyChunks[i];
+			ChunkMesh& mesh = chunk->Mesh;
+			chunkBuffers->Free(mesh.vertexOffset, mesh.vertexCount, mesh.firstIndex, mesh.indexCount);
+
+			mesh.vertexCount = meshFaces[i] * 4;
+			mesh.indexCount = meshFaces[i] * 6;
+			mesh.faceIndexCounts = meshFaceCounts[i];
+			chunkBuffers->Allocate(mesh.vertexCount, mesh.indexCount, mesh.vertexOffset, mesh.firstIndex);
+
+			if (meshFaces[i] > 0)
 			{
-				*(writePtr) = *(readPtr) + VoxelModel::VERTICIES_PER_VOXEL * voxelOn;
+				GpuMeshJob* job = gpuMesher->AddJob(currentFrame);
+				glm::ivec3 origin = chunk->Position * CHUNK_SIZE;
+				job->origin[0] = origin.x;
+				job->origin[1] = origin.y;
+				job->origin[2] = origin.z;
+				job->vertexOffset = mesh.vertexOffset;
+				job->firstIndex = mesh.firstIndex;
+
+				const Chunk* neighbourhood[27];
+				chunks.GetNeighbourhood(chunk->Position, neighbourhood);
+				for (uint32_t n = 0; n < 27; ++n) job->slots[n] = neighbourhood[n] != nullptr ? neighbourhood[n]->GpuSlot : GpuChunkMesher::NO_SLOT;
+				memcpy(job->rowOffsets, meshRowOffsets[i].data(), sizeof(job->rowOffsets));
 			}
 
-			++voxelOn;
+			chunk->Dirty = false;
+			if (LightEngine::IsOpenSky(*chunk)) removeChunk(chunk); //empty, it has no job and its mesh is freed above
 		}
-		ri.numIndices = voxelOn * 36;
+		finishChunkUpdate();
+
+		return true;
+	}
+
+	//one range per run of visible face groups that are next to each other in the mesh
+	void addChunkDrawRanges(const ChunkMesh& mesh, uint32_t visibleFaces)
+	{
+		uint32_t firstIndex = mesh.firstIndex;
+		uint32_t runStart = firstIndex, runCount = 0;
 
-		vkUnmapMemory(device, stagingBufferMemory);
+		for (uint32_t face : FACE_GROUP_ORDER)
+		{
+			uint32_t count = mesh.faceIndexCounts[face];
+			if (count == 0) continue; //an empty group doesn't break a run
 
-		BufferHelpers::CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ri.indexBuffer, ri.indexBufferMemory, ri.deviceHandler);
-		BufferHelpers::CopyBuffer(stagingBuffer, ri.indexBuffer, bufferSize, ri.commandBuffersHandler);
+			if (visibleFaces & (1u << face))
+			{
+				if (runCount == 0) runStart = firstIndex;
+				runCount += count;
+			}
+			else if (runCount > 0)
+			{
+				ri.chunkDrawRanges.push_back({ runStart, runCount, static_cast<int32_t>(mesh.vertexOffset) });
+				runCount = 0;
+			}
+			firstIndex += count;
+		}
+
+		if (runCount > 0) ri.chunkDrawRanges.push_back({ runStart, runCount, static_cast<int32_t>(mesh.vertexOffset) });
+	}
+
+	inline void markDirty(Chunk* chunk)
+	{
+		if (chunk->Dirty) return;
+		chunk->Dirty = true;
+		dirtyChunks.push_back(chunk);
+	}
+
+	//bakes voxels [first, last) of the group, safe to run on several threads at once for disjoint ranges
+	void bakeVoxels(const BakeSource& source, uint32_t first, uint32_t last, Vertex* vertices, VertexIndex* indices)
+	{
+		//the group owns these, so their first size elements are in group order (storage iterators count down from end)
+		auto transforms = source.transforms->end() - source.size;
+		auto meshes = source.meshes->end() - source.size;
+		auto renders = source.renders->end() - source.size;
+
+		//built in cached memory, then copied out in one go since the destination is usually write combined
+		Vertex voxelVertices[VoxelModel::VERTICIES_PER_VOXEL];
+		VertexIndex voxelIndices[VoxelModel::INDICES_PER_VOXEL];
+		float bakedX[VoxelModel::VERTICIES_PER_VOXEL], bakedY[VoxelModel::VERTICIES_PER_VOXEL], bakedZ[VoxelModel::VERTICIES_PER_VOXEL];
+
+		for (uint32_t v = 0; v < VoxelModel::VERTICIES_PER_VOXEL; ++v) voxelVertices[v].texCoord = glm::vec2(CubeGeometry::FACE_UVS[v % 4][0], CubeGeometry::FACE_UVS[v % 4][1]);
+
+		for (uint32_t batch = first; batch < last; batch += 4)
+		{
+			uint32_t batchEnd = std::min(batch + 4, last);
+
+			//one matrix per voxel, four at a time, a partial batch repeats its last voxel
+			const TransformComponent* batchTransforms[4];
+			glm::mat4 matrices[4];
+			glm::mat4* batchMatrices[4];
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				uint32_t voxel = std::min(batch + lane, batchEnd - 1);
+				batchTransforms[lane] = &transforms[voxel];
+				batchMatrices[lane] = &matrices[voxel - batch];
+			}
+			TransformBatch::compute4(batchTransforms, batchMatrices);
+
+			for (uint32_t voxel = batch; voxel < batchEnd; ++voxel)
+			{
+				const MeshComponent& mesh = meshes[voxel];
+				uint32_t objectIndex = renders[voxel].ObjectIndex;
+				glm::vec3 color = UnpackColor(mesh.Color);
+
+				if (objectIndex != 0)
+				{
+					//the vertex shader applies the object's model matrix
+					for (uint32_t v = 0; v < VoxelModel::VERTICIES_PER_VOXEL; ++v) voxelVertices[v].pos = glm::vec3(cubeX[v], cubeY[v], cubeZ[v]);
+				}
+				else
+				{
+					TransformBatch::TransformPoints(matrices[voxel - batch], cubeX.data(), cubeY.data(), cubeZ.data(), VoxelModel::VERTICIES_PER_VOXEL, bakedX, bakedY, bakedZ);
+					for (uint32_t v = 0; v < VoxelModel::VERTICIES_PER_VOXEL; ++v) voxelVertices[v].pos = glm::vec3(bakedX[v], bakedY[v], bakedZ[v]);
+				}
+
+				for (Vertex& vertex : voxelVertices)
+				{
+					vertex.color = color;
+					vertex.materialId = mesh.Material;
+					vertex.objectIndex = objectIndex;
+				}
+
+				uint32_t localVertex = (voxel % VOXELS_PER_DRAW) * VoxelModel::VERTICIES_PER_VOXEL;
+				for (uint32_t i = 0; i < VoxelModel::INDICES_PER_VOXEL; ++i) voxelIndices[i] = static_cast<VertexIndex>(CubeGeometry::INDEX_DATA[i] + localVertex);
+
+				memcpy(vertices + voxel * VoxelModel::VERTICIES_PER_VOXEL, voxelVertices, sizeof(voxelVertices));
+				memcpy(indices + voxel * VoxelModel::INDICES_PER_VOXEL, voxelIndices, sizeof(voxelIndices));
+			}
+		}
+	}
+
+	//both buffers are filled in one WriteGeometry pass, written straight into their device local memory when it can be mapped
+	//(integrated GPUs, software rasterizers, resizable BAR), otherwise into staging buffers that are then copied over
+	void createBuffers(DeletionQueueHandler* deletionQueue)
+	{
+		destroyBuffers(deletionQueue);
+
+		if (GetVoxelCount() == 0) //a scene of only grid chunks, Vulkan buffers can't be empty
+		{
+			ri.numIndices = 0;
+			ri.drawRanges.clear();
+			return;
+		}
+
+		VkDeviceSize vertexBufferSize = sizeof(Vertex) * VoxelModel::VERTICIES_PER_VOXEL * GetVoxelCount();
+		VkDeviceSize indexBufferSize = sizeof(VertexIndex) * VoxelModel::INDICES_PER_VOXEL * GetVoxelCount();
+
+		VkDevice& device = ri.deviceHandler->getLogicalDevice();
+
+		VkBuffer vertexStagingBuffer = VK_NULL_HANDLE, indexStagingBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory vertexStagingBufferMemory = VK_NULL_HANDLE, indexStagingBufferMemory = VK_NULL_HANDLE;
+
+		void* vertexData;
+		void* indexData;
+		createMappedBuffer(vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, ri.vertexBuffer, ri.vertexBufferMemory, vertexStagingBuffer, vertexStagingBufferMemory, vertexData);
+		createMappedBuffer(indexBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, ri.indexBuffer, ri.indexBufferMemory, indexStagingBuffer, indexStagingBufferMemory, indexData);
+
+		ri.numIndices = WriteGeometry((Vertex*)vertexData, (VertexIndex*)indexData);
+
+		vkUnmapMemory(device, vertexStagingBuffer != VK_NULL_HANDLE ? vertexStagingBufferMemory : ri.vertexBufferMemory);
+		vkUnmapMemory(device, indexStagingBuffer != VK_NULL_HANDLE ? indexStagingBufferMemory : ri.indexBufferMemory);
+
+		ri.drawRanges.clear();
+		const uint32_t indicesPerDraw = VOXELS_PER_DRAW * VoxelModel::INDICES_PER_VOXEL;
+		for (uint32_t first = 0; first < ri.numIndices; first += indicesPerDraw)
+		{
+			int32_t vertexOffset = static_cast<int32_t>(first / VoxelModel::INDICES_PER_VOXEL * VoxelModel::VERTICIES_PER_VOXEL);
+			ri.drawRanges.push_back({ first, std::min(indicesPerDraw, ri.numIndices - first), vertexOffset });
+		}
+
+		if (vertexStagingBuffer != VK_NULL_HANDLE)
+		{
+			BufferHelpers::CopyBuffer(vertexStagingBuffer, ri.vertexBuffer, vertexBufferSize, ri.commandBuffersHandler);
+			vkDestroyBuffer(device, vertexStagingBuffer, nullptr);
+			ri.deviceHandler->freeMemory(vertexStagingBufferMemory);
+		}
+
+		if (indexStagingBuffer != VK_NULL_HANDLE)
+		{
+			BufferHelpers::CopyBuffer(indexStagingBuffer, ri.indexBuffer, indexBufferSize, ri.commandBuffersHandler);
+			vkDestroyBuffer(device, indexStagingBuffer, nullptr);
+			ri.deviceHandler->freeMemory(indexStagingBufferMemory);
+		}
+	}
+
+	//the previous bake's buffers, destroyed once the frames already submitted are done with them (or right away without a queue)
+	void destroyBuffers(DeletionQueueHandler* deletionQueue)
+	{
+		if (ri.vertexBuffer == VK_NULL_HANDLE) return;
+
+		DeviceHandler* dh = ri.deviceHandler;
+		VkBuffer vertexBuffer = ri.vertexBuffer, indexBuffer = ri.indexBuffer;
+		VkDeviceMemory vertexMemory = ri.vertexBufferMemory, indexMemory = ri.indexBufferMemory;
+		auto destroy = [dh, vertexBuffer, vertexMemory, indexBuffer, indexMemory]() {
+			vkDestroyBuffer(dh->getLogicalDevice(), vertexBuffer, nullptr);
+			dh->freeMemory(vertexMemory);
+			vkDestroyBuffer(dh->getLogicalDevice(), indexBuffer, nullptr);
+			dh->freeMemory(indexMemory);
+		};
+		if (deletionQueue != nullptr) deletionQueue->Defer(destroy);
+		else destroy();
+
+		ri.vertexBuffer = VK_NULL_HANDLE;
+		ri.vertexBufferMemory = VK_NULL_HANDLE;
+		ri.indexBuffer = VK_NULL_HANDLE;
+		ri.indexBufferMemory = VK_NULL_HANDLE;
+	}
+
+	//maps buffer itself if it could be put in mapped device local memory, otherwise creates a mapped staging buffer for it
+	void createMappedBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory, VkBuffer& stagingBuffer, VkDeviceMemory& stagingMemory, void*& mapped)
+	{
+		if (BufferHelpers::CreateMappedDeviceLocalBuffer(size, usage, buffer, memory, mapped, ri.deviceHandler)) return;
 
-		vkDestroyBuffer(device, stagingBuffer, nullptr);
-		vkFreeMemory(device, stagingBufferMemory, nullptr);
+		BufferHelpers::CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingMemory, ri.deviceHandler);
+		vkMapMemory(ri.deviceHandler->getLogicalDevice(), stagingMemory, 0, size, 0, &mapped);
+		BufferHelpers::CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, memory, ri.deviceHandler);
 	}
 };
\ No newline at end of file
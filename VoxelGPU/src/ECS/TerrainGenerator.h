@@ -0,0 +1,222 @@
+#pragma once
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+#include "Chunk.h"
+
+//procedural terrain for the voxel grid, the same seed always gives the same world
+//a height per column of cells from 2D simplex noise: fBm (octaves summed at rising frequency and falling amplitude) of a
+//domain warped position (offset by two more, lower frequency fBm lookups first, which bends ridges and valleys around)
+//heights are evaluated 4 columns per SSE register, once per column of chunks, and the cells are written straight into
+//Chunk::Voxels, so chunks can be generated on any number of threads at once (see Scene::GenerateTerrain)
+//shaders/terrain.comp evaluates the same heights on the GPU (see GpuTerrainGenerator), keep the two in step
+class TerrainGenerator
+{
+public:
+	struct Settings
+	{
+		uint32_t Seed = 1;
+		float Frequency = 1.0f / 96.0f; //of the first octave, per cell
+		uint32_t Octaves = 5;
+		float Lacunarity = 2.0f; //frequency multiplier per octave
+		float Persistence = 0.5f; //amplitude multiplier per octave
+		float WarpFrequency = 1.0f / 192.0f;
+		uint32_t WarpOctaves = 2;
+		float WarpStrength = 24.0f; //in cells
+		float BaseHeight = -16.0f; //in cells, where the noise is 0
+		float Amplitude = 14.0f; //in cells, how far the noise moves the surface up or down
+		int SoilDepth = 3; //cells of dirt under the grass, stone below that
+	};
+
+private:
+	Settings settings;
+	GridVoxel grass, dirt, stone;
+
+	//8 evenly spread directions, indexed by the low 3 bits of a corner's hash
+	static constexpr float GRADIENTS[8][2] = {
+		{ 1.0f, 0.0f }, { -1.0f, 0.0f }, { 0.0f, 1.0f }, { 0.0f, -1.0f },
+		{ 0.70710678f, 0.70710678f }, { -0.70710678f, 0.70710678f }, { 0.70710678f, -0.70710678f }, { -0.70710678f, -0.70710678f },
+	};
+
+public:
+	TerrainGenerator(const Settings& _settings) : settings(_settings)
+	{
+		grass.Color = PackColor(glm::vec3(0.30f, 0.60f, 0.22f));
+		dirt.Color = PackColor(glm::vec3(0.45f, 0.32f, 0.20f));
+		stone.Color = PackColor(glm::vec3(0.50f, 0.50f, 0.52f));
+		grass.Solid = dirt.Solid = stone.Solid = true;
+	}
+
+	inline const Settings& getSettings() const { return settings; }
+	inline const GridVoxel& getGrass() const { return grass; }
+	inline const GridVoxel& getDirt() const { return dirt; }
+	inline const GridVoxel& getStone() const { return stone; }
+
+	//what fbm's sum of that many octaves is multiplied by, so it stays within about -1 to 1
+	float FbmScale(uint32_t octaves) const
+	{
+		float amplitude = 1.0f, totalAmplitude = 0.0f;
+		for (uint32_t octave = 0; octave < octaves; ++octave)
+		{
+			totalAmplitude += amplitude;
+			amplitude *= settings.Persistence;
+		}
+		return 1.0f / totalAmplitude;
+	}
+
+	//the surface height (the highest solid cell) of the CHUNK_SIZE x CHUNK_SIZE columns from (cellX, cellZ), x fastest
+	void ColumnHeights(int cellX, int cellZ, int32_t heights[CHUNK_SIZE * CHUNK_SIZE]) const
+	{
+		static_assert(CHUNK_SIZE % 4 == 0, "Columns are evaluated 4 at a time");
+
+		const __m128 laneOffsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+		const __m128 warpStrength = _mm_set1_ps(settings.WarpStrength);
+
+		for (int z = 0; z < CHUNK_SIZE; ++z)
+		{
+			for (int x = 0; x < CHUNK_SIZE; x += 4)
+			{
+				//cell centres
+				__m128 px = _mm_add_ps(_mm_set1_ps(cellX + x + 0.5f), laneOffsets);
+				__m128 pz = _mm_set1_ps(cellZ + z + 0.5f);
+
+				__m128 warpX = fbm(px, pz, settings.WarpFrequency, settings.WarpOctaves, settings.Seed + 1);
+				__m128 warpZ = fbm(px, pz, settings.WarpFrequency, settings.WarpOctaves, settings.Seed + 2);
+				px = _mm_add_ps(px, _mm_mul_ps(warpX, warpStrength));
+				pz = _mm_add_ps(pz, _mm_mul_ps(warpZ, warpStrength));
+
+				__m128 height = _mm_add_ps(_mm_set1_ps(settings.BaseHeight), _mm_mul_ps(fbm(px, pz, settings.Frequency, settings.Octaves, settings.Seed), _mm_set1_ps(settings.Amplitude)));
+				_mm_storeu_si128((__m128i*)&heights[z * CHUNK_SIZE + x], floorToInt(height));
+			}
+		}
+	}
+
+	//fills every cell of the chunk from its column's heights (see ColumnHeights), returns the chunk's solid cell count
+	//only touches the chunk's voxels, its light is left to LightEngine::ChunksGenerated
+	uint32_t FillChunk(Chunk& chunk, const int32_t heights[CHUNK_SIZE * CHUNK_SIZE]) const
+	{
+		const GridVoxel air;
+		int chunkY = chunk.Position.y * CHUNK_SIZE;
+		uint32_t solidCount = 0;
+
+		for (int y = 0; y < CHUNK_SIZE; ++y)
+		{
+			int cellY = chunkY + y;
+			GridVoxel* row = &chunk.Voxels[Chunk::Index(0, y, 0)];
+
+			for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; ++i)
+			{
+				int depth = heights[i] - cellY;
+				if (depth < 0) row[i] = air;
+				else
+				{
+					row[i] = depth == 0 ? grass : depth <= settings.SoilDepth ? dirt : stone;
+					++solidCount;
+				}
+			}
+		}
+
+		chunk.SolidCount = solidCount;
+		return solidCount;
+	}
+
+private:
+	//SSE2 has no floor, truncate and step down where that rounded up
+	static inline __m128i floorToInt(__m128 v)
+	{
+		__m128i truncated = _mm_cvttps_epi32(v);
+		__m128 roundedUp = _mm_cmpgt_ps(_mm_cvtepi32_ps(truncated), v);
+		return _mm_add_epi32(truncated, _mm_castps_si128(roundedUp)); //the mask is -1 where it rounded up
+	}
+
+	//sum of octaves of simplex noise at (x, z) * frequency, normalized to about -1 to 1
+	__m128 fbm(__m128 x, __m128 z, float frequency, uint32_t octaves, uint32_t seed) const
+	{
+		__m128 sum = _mm_setzero_ps();
+		float amplitude = 1.0f;
+
+		for (uint32_t octave = 0; octave < octaves; ++octave)
+		{
+			__m128 f = _mm_set1_ps(frequency);
+			sum = _mm_add_ps(sum, _mm_mul_ps(simplex(_mm_mul_ps(x, f), _mm_mul_ps(z, f), seed + octave * 0x9E3779B9u), _mm_set1_ps(amplitude)));
+			frequency *= settings.Lacunarity;
+			amplitude *= settings.Persistence;
+		}
+
+		return _mm_mul_ps(sum, _mm_set1_ps(FbmScale(octaves)));
+	}
+
+	static inline uint32_t hash(int32_t i, int32_t j, uint32_t seed)
+	{
+		uint32_t h = seed ^ (static_cast<uint32_t>(i) * 0x27D4EB2Du) ^ (static_cast<uint32_t>(j) * 0x165667B1u);
+		h ^= h >> 15;
+		h *= 0x2C1B3C6Du;
+		h ^= h >> 12;
+		return h;
+	}
+
+	//2D simplex noise, about -1 to 1
+	//the lattice hashes and gradient lookups are per lane (SSE2 has no gather or 32 bit multiply), everything else is 4 wide
+	static __m128 simplex(__m128 x, __m128 y, uint32_t seed)
+	{
+		const float F2 = 0.36602540378f; //(sqrt(3) - 1) / 2, skews the input onto the triangle lattice
+		const float G2 = 0.21132486540f; //(3 - sqrt(3)) / 6, unskews back
+		const __m128 g2 = _mm_set1_ps(G2);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+
+		__m128 s = _mm_mul_ps(_mm_add_ps(x, y), _mm_set1_ps(F2));
+		__m128i i = floorToInt(_mm_add_ps(x, s));
+		__m128i j = floorToInt(_mm_add_ps(y, s));
+		__m128 fi = _mm_cvtepi32_ps(i), fj = _mm_cvtepi32_ps(j);
+
+		//offsets from the triangle's three corners
+		__m128 t = _mm_mul_ps(_mm_add_ps(fi, fj), g2);
+		__m128 x0 = _mm_sub_ps(x, _mm_sub_ps(fi, t));
+		__m128 y0 = _mm_sub_ps(y, _mm_sub_ps(fj, t));
+		__m128 lower = _mm_cmpgt_ps(x0, y0); //the lower triangle's middle corner is a step in x, the upper's one in y
+		__m128 i1 = _mm_and_ps(lower, one);
+		__m128 j1 = _mm_andnot_ps(lower, one);
+		__m128 x1 = _mm_add_ps(_mm_sub_ps(x0, i1), g2);
+		__m128 y1 = _mm_add_ps(_mm_sub_ps(y0, j1), g2);
+		__m128 x2 = _mm_add_ps(_mm_sub_ps(x0, one), _mm_set1_ps(2.0f * G2));
+		__m128 y2 = _mm_add_ps(_mm_sub_ps(y0, one), _mm_set1_ps(2.0f * G2));
+
+		alignas(16) int32_t is[4], js[4];
+		alignas(16) float steps[4];
+		_mm_store_si128((__m128i*)is, i);
+		_mm_store_si128((__m128i*)js, j);
+		_mm_store_ps(steps, i1);
+
+		alignas(16) float gx[3][4], gy[3][4];
+		for (uint32_t lane = 0; lane < 4; ++lane)
+		{
+			int32_t stepX = steps[lane] != 0.0f, stepY = 1 - stepX;
+			uint32_t corners[3] = { hash(is[lane], js[lane], seed), hash(is[lane] + stepX, js[lane] + stepY, seed), hash(is[lane] + 1, js[lane] + 1, seed) };
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				gx[corner][lane] = GRADIENTS[corners[corner] & 7][0];
+				gy[corner][lane] = GRADIENTS[corners[corner] & 7][1];
+			}
+		}
+
+		//each corner adds (0.5 - d^2)^4 * dot(gradient, offset), 0 past a distance of sqrt(0.5)
+		__m128 cx[3] = { x0, x1, x2 }, cy[3] = { y0, y1, y2 };
+		__m128 sum = _mm_setzero_ps();
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			__m128 falloff = _mm_sub_ps(half, _mm_add_ps(_mm_mul_ps(cx[corner], cx[corner]), _mm_mul_ps(cy[corner], cy[corner])));
+			falloff = _mm_max_ps(falloff, _mm_setzero_ps());
+			falloff = _mm_mul_ps(falloff, falloff);
+			falloff = _mm_mul_ps(falloff, falloff);
+
+			__m128 dot = _mm_add_ps(_mm_mul_ps(_mm_load_ps(gx[corner]), cx[corner]), _mm_mul_ps(_mm_load_ps(gy[corner]), cy[corner]));
+			sum = _mm_add_ps(sum, _mm_mul_ps(falloff, dot));
+		}
+
+		return _mm_mul_ps(sum, _mm_set1_ps(70.0f));
+	}
+};
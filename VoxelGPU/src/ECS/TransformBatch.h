@@ -0,0 +1,145 @@
+#pragma once
+
+#include <xmmintrin.h>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+#include <cmath>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Components/TransformComponent.h"
+
+//TransformComponent::GetTransformMatrix for many transforms at once, four per SSE register (one transform per lane)
+//sin/cos are scalar, the quaternion, rotation matrix, scale and translation are all done 4 wide
+namespace TransformBatch
+{
+	void compute4(const TransformComponent* const transforms[4], glm::mat4* const out[4])
+	{
+		alignas(16) float cosX[4], cosY[4], cosZ[4], sinX[4], sinY[4], sinZ[4];
+		alignas(16) float scaleX[4], scaleY[4], scaleZ[4], translationX[4], translationY[4], translationZ[4];
+
+		for (uint32_t lane = 0; lane < 4; ++lane)
+		{
+			const TransformComponent& t = *transforms[lane];
+			//half angles, same as glm::quat(eulerAngles)
+			cosX[lane] = std::cos(t.Rotation.x * 0.5f); sinX[lane] = std::sin(t.Rotation.x * 0.5f);
+			cosY[lane] = std::cos(t.Rotation.y * 0.5f); sinY[lane] = std::sin(t.Rotation.y * 0.5f);
+			cosZ[lane] = std::cos(t.Rotation.z * 0.5f); sinZ[lane] = std::sin(t.Rotation.z * 0.5f);
+			scaleX[lane] = t.Scale.x; scaleY[lane] = t.Scale.y; scaleZ[lane] = t.Scale.z;
+			translationX[lane] = t.Translation.x; translationY[lane] = t.Translation.y; translationZ[lane] = t.Translation.z;
+		}
+
+		__m128 cx = _mm_load_ps(cosX), cy = _mm_load_ps(cosY), cz = _mm_load_ps(cosZ);
+		__m128 sx = _mm_load_ps(sinX), sy = _mm_load_ps(sinY), sz = _mm_load_ps(sinZ);
+
+		//euler angles to quaternion
+		__m128 qw = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(cx, cy), cz), _mm_mul_ps(_mm_mul_ps(sx, sy), sz));
+		__m128 qx = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(sx, cy), cz), _mm_mul_ps(_mm_mul_ps(cx, sy), sz));
+		__m128 qy = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(cx, sy), cz), _mm_mul_ps(_mm_mul_ps(sx, cy), sz));
+		__m128 qz = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(cx, cy), sz), _mm_mul_ps(_mm_mul_ps(sx, sy), cz));
+
+		//quaternion to rotation matrix, same as glm::mat3_cast
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		__m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+		__m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+		__m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+		//column c, row r is m[c][r], each column is scaled by its axis' scale
+		__m128 sX = _mm_load_ps(scaleX), sY = _mm_load_ps(scaleY), sZ = _mm_load_ps(scaleZ);
+		__m128 columns[4][4] = {
+			{
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sX),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sX),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sX),
+				_mm_setzero_ps()
+			},
+			{
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sY),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sY),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sY),
+				_mm_setzero_ps()
+			},
+			{
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sZ),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sZ),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sZ),
+				_mm_setzero_ps()
+			},
+			{ _mm_load_ps(translationX), _mm_load_ps(translationY), _mm_load_ps(translationZ), one }
+		};
+
+		//lanes hold one transform each, transposing turns them into the columns of each transform's matrix
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			__m128 a = columns[c][0], b = columns[c][1], d = columns[c][2], e = columns[c][3];
+			_MM_TRANSPOSE4_PS(a, b, d, e);
+			_mm_storeu_ps(&(*out[0])[c][0], a);
+			_mm_storeu_ps(&(*out[1])[c][0], b);
+			_mm_storeu_ps(&(*out[2])[c][0], d);
+			_mm_storeu_ps(&(*out[3])[c][0], e);
+		}
+	}
+
+	//out[outIndices[i]] = transforms[i].GetTransformMatrix() for i in 0..count-1, or out[i] if outIndices is nullptr
+	void ComputeMatrices(const TransformComponent* transforms, size_t count, glm::mat4* out, const uint32_t* outIndices = nullptr)
+	{
+		for (size_t first = 0; first < count; first += 4)
+		{
+			const TransformComponent* in[4];
+			glm::mat4* results[4];
+
+			//a partial last batch repeats its last transform, writing the same matrix twice is harmless
+			for (size_t lane = 0; lane < 4; ++lane)
+			{
+				size_t i = first + lane < count ? first + lane : count - 1;
+				in[lane] = transforms + i;
+				results[lane] = out + (outIndices != nullptr ? outIndices[i] : i);
+			}
+
+			compute4(in, results);
+		}
+	}
+
+	//out = (m * vec4(in, 1)).xyz for count points stored as separate x/y/z arrays, 8 per AVX register when built with AVX, 4 per SSE register otherwise
+	void TransformPoints(const glm::mat4& m, const float* inX, const float* inY, const float* inZ, uint32_t count, float* outX, float* outY, float* outZ)
+	{
+		uint32_t i = 0;
+
+#ifdef __AVX__
+		__m256 m00 = _mm256_set1_ps(m[0][0]), m01 = _mm256_set1_ps(m[0][1]), m02 = _mm256_set1_ps(m[0][2]);
+		__m256 m10 = _mm256_set1_ps(m[1][0]), m11 = _mm256_set1_ps(m[1][1]), m12 = _mm256_set1_ps(m[1][2]);
+		__m256 m20 = _mm256_set1_ps(m[2][0]), m21 = _mm256_set1_ps(m[2][1]), m22 = _mm256_set1_ps(m[2][2]);
+		__m256 m30 = _mm256_set1_ps(m[3][0]), m31 = _mm256_set1_ps(m[3][1]), m32 = _mm256_set1_ps(m[3][2]);
+
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 x = _mm256_loadu_ps(inX + i), y = _mm256_loadu_ps(inY + i), z = _mm256_loadu_ps(inZ + i);
+			_mm256_storeu_ps(outX + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, x), _mm256_mul_ps(m10, y)), _mm256_add_ps(_mm256_mul_ps(m20, z), m30)));
+			_mm256_storeu_ps(outY + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m01, x), _mm256_mul_ps(m11, y)), _mm256_add_ps(_mm256_mul_ps(m21, z), m31)));
+			_mm256_storeu_ps(outZ + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m02, x), _mm256_mul_ps(m12, y)), _mm256_add_ps(_mm256_mul_ps(m22, z), m32)));
+		}
+#endif
+
+		__m128 n00 = _mm_set1_ps(m[0][0]), n01 = _mm_set1_ps(m[0][1]), n02 = _mm_set1_ps(m[0][2]);
+		__m128 n10 = _mm_set1_ps(m[1][0]), n11 = _mm_set1_ps(m[1][1]), n12 = _mm_set1_ps(m[1][2]);
+		__m128 n20 = _mm_set1_ps(m[2][0]), n21 = _mm_set1_ps(m[2][1]), n22 = _mm_set1_ps(m[2][2]);
+		__m128 n30 = _mm_set1_ps(m[3][0]), n31 = _mm_set1_ps(m[3][1]), n32 = _mm_set1_ps(m[3][2]);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(inX + i), y = _mm_loadu_ps(inY + i), z = _mm_loadu_ps(inZ + i);
+			_mm_storeu_ps(outX + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(n00, x), _mm_mul_ps(n10, y)), _mm_add_ps(_mm_mul_ps(n20, z), n30)));
+			_mm_storeu_ps(outY + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(n01, x), _mm_mul_ps(n11, y)), _mm_add_ps(_mm_mul_ps(n21, z), n31)));
+			_mm_storeu_ps(outZ + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(n02, x), _mm_mul_ps(n12, y)), _mm_add_ps(_mm_mul_ps(n22, z), n32)));
+		}
+
+		for (; i < count; ++i)
+		{
+			outX[i] = m[0][0] * inX[i] + m[1][0] * inY[i] + m[2][0] * inZ[i] + m[3][0];
+			outY[i] = m[0][1] * inX[i] + m[1][1] * inY[i] + m[2][1] * inZ[i] + m[3][1];
+			outZ[i] = m[0][2] * inX[i] + m[1][2] * inY[i] + m[2][2] * inZ[i] + m[3][2];
+		}
+	}
+}
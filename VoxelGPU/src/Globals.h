@@ -1,9 +1,17 @@
 #pragma once
-#define MAX_FRAMES_IN_FLIGHT 2
+#include <vector>
+
+//per frame resources are created for MAX_FRAMES_IN_FLIGHT frames, Renderer::setFramesInFlight picks how many are used (1 to MAX)
+#define MAX_FRAMES_IN_FLIGHT 3
+#define DEFAULT_FRAMES_IN_FLIGHT 2
 #define DEBUG
 
 const uint32_t WIDTH = 1280;
 const uint32_t HEIGHT = 720;
 
 const char* MODEL_PATH = "models/viking_room.obj";
-const char* TEXTURE_PATH = "textures/viking_room.png";
\ No newline at end of file
+const char* TEXTURE_PATH = "textures/viking_room.png";
+
+//one texture array layer per material, material ID n samples MATERIAL_TEXTURE_PATHS[n - 1] (0 is untextured, see MATERIAL_NONE)
+//all entries must have the same dimensions
+const std::vector<const char*> MATERIAL_TEXTURE_PATHS = { TEXTURE_PATH };
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <stdint.h>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX //windows.h would otherwise break std::min/std::max
+	#endif
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+//read-only memory mapping of a whole file, unmapped when this goes out of scope
+//the OS pages the file in on demand, so nothing is copied until the data is actually touched
+class MappedFile
+{
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+#else
+	int fd = -1;
+#endif
+
+public:
+	MappedFile(const char* path)
+	{
+#ifdef _WIN32
+		file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE) throw std::runtime_error(std::string("Failed to open file for mapping: ") + path);
+
+		LARGE_INTEGER fileSize;
+		GetFileSizeEx(file, &fileSize);
+		size = static_cast<size_t>(fileSize.QuadPart);
+
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping != NULL) data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+		if (data == nullptr) {
+			release(); //destructor doesn't run if the constructor throws
+			throw std::runtime_error(std::string("Failed to map file: ") + path);
+		}
+#else
+		fd = open(path, O_RDONLY);
+		if (fd < 0) throw std::runtime_error(std::string("Failed to open file for mapping: ") + path);
+
+		struct stat st;
+		fstat(fd, &st);
+		size = static_cast<size_t>(st.st_size);
+
+		void* ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (ptr == MAP_FAILED) {
+			release(); //destructor doesn't run if the constructor throws
+			throw std::runtime_error(std::string("Failed to map file: ") + path);
+		}
+
+		madvise(ptr, size, MADV_SEQUENTIAL);
+		data = static_cast<const uint8_t*>(ptr);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile() { release(); }
+
+	inline const uint8_t* getData() const { return data; }
+	inline size_t getSize() const { return size; }
+
+private:
+	void release()
+	{
+#ifdef _WIN32
+		if (data) UnmapViewOfFile(data);
+		if (mapping) CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+		if (data) munmap(const_cast<uint8_t*>(data), size);
+		if (fd >= 0) close(fd);
+#endif
+	}
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+
+//phases of Renderer::drawFrame, in the order they happen
+enum ProfilePhase : uint32_t {
+	PHASE_FENCE_WAIT = 0,
+	PHASE_ACQUIRE,
+	PHASE_INPUT,
+	PHASE_UBO_UPDATE,
+	PHASE_CHUNK_UPDATE,
+	PHASE_RECORD,
+	PHASE_SUBMIT,
+	PHASE_PRESENT,
+	PHASE_COUNT
+};
+
+const char* const PROFILE_PHASE_NAMES[PHASE_COUNT] = { "Fence wait", "Acquire", "Input", "UBO update", "Chunk update", "Record", "Submit", "Present" };
+
+//passes in recordCommandBuffer that are bracketed by GPU timestamps
+enum GpuPass : uint32_t {
+	GPU_PASS_SCENE = 0,
+	GPU_PASS_IMGUI,
+	GPU_PASS_COUNT
+};
+
+const char* const GPU_PASS_NAMES[GPU_PASS_COUNT] = { "Scene", "ImGui" };
+
+//collects CPU phase timings and GPU pass timings per frame into a rolling history for the overlay
+class Profiler
+{
+public:
+	static const uint32_t HISTORY_SIZE = 240;
+
+private:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	//current frame, accumulated until EndFrame
+	float phaseMs[PHASE_COUNT] = {};
+	float gpuPassMs[GPU_PASS_COUNT] = {};
+	float gpuMs = 0.0f;
+	float latencyMs = 0.0f;
+
+	//ring buffers, historyOffset is the oldest entry (what ImGui::PlotLines wants as values_offset)
+	float frameHistory[HISTORY_SIZE] = {};
+	float gpuHistory[HISTORY_SIZE] = {};
+	float latencyHistory[HISTORY_SIZE] = {};
+	float cpuBusyHistory[HISTORY_SIZE] = {};
+	float phaseHistory[PHASE_COUNT][HISTORY_SIZE] = {};
+	float gpuPassHistory[GPU_PASS_COUNT][HISTORY_SIZE] = {};
+	uint32_t historyOffset = 0;
+	uint32_t framesRecorded = 0;
+
+	Clock::time_point lastFrameEnd = Clock::now();
+
+public:
+	inline void AddPhaseTime(ProfilePhase phase, float ms) { phaseMs[phase] += ms; }
+
+	//GPU results arrive frames after they were recorded (once the fence has signaled), they are filed under the frame that read them
+	void SetGpuTimings(const float* passMs, float totalMs)
+	{
+		for (uint32_t i = 0; i < GPU_PASS_COUNT; ++i) gpuPassMs[i] = passMs[i];
+		gpuMs = totalMs;
+	}
+
+	//like GPU timings, latency is only known once the frame has finished rendering, and is filed under the frame that saw it
+	inline void SetLatency(float ms) { latencyMs = ms; }
+
+	void EndFrame()
+	{
+		Clock::time_point now = Clock::now();
+		float frameMs = std::chrono::duration<float, std::milli>(now - lastFrameEnd).count();
+		lastFrameEnd = now;
+
+		frameHistory[historyOffset] = frameMs;
+		gpuHistory[historyOffset] = gpuMs;
+		latencyHistory[historyOffset] = latencyMs;
+		//time the CPU spent waiting on the GPU or the presentation engine doesn't count as work
+		cpuBusyHistory[historyOffset] = frameMs - phaseMs[PHASE_FENCE_WAIT] - phaseMs[PHASE_ACQUIRE];
+
+		for (uint32_t i = 0; i < PHASE_COUNT; ++i)
+		{
+			phaseHistory[i][historyOffset] = phaseMs[i];
+			phaseMs[i] = 0.0f;
+		}
+
+		for (uint32_t i = 0; i < GPU_PASS_COUNT; ++i) gpuPassHistory[i][historyOffset] = gpuPassMs[i];
+
+		historyOffset = (historyOffset + 1) % HISTORY_SIZE;
+		if (framesRecorded < HISTORY_SIZE) ++framesRecorded;
+	}
+
+	inline float getLastGpuMs() const { return gpuMs; }
+	inline float getLastLatencyMs() const { return latencyMs; }
+
+	inline const float* getFrameHistory() const { return frameHistory; }
+	inline const float* getGpuHistory() const { return gpuHistory; }
+	inline const float* getLatencyHistory() const { return latencyHistory; }
+	inline uint32_t getHistoryOffset() const { return historyOffset; }
+
+	inline float getAverageFrameMs() const { return average(frameHistory); }
+	inline float getAverageGpuMs() const { return average(gpuHistory); }
+	inline float getAverageCpuBusyMs() const { return average(cpuBusyHistory); }
+	inline float getAverageLatencyMs() const { return average(latencyHistory); }
+	inline float getMaxLatencyMs() const { return maximum(latencyHistory); }
+	inline float getAveragePhaseMs(ProfilePhase phase) const { return average(phaseHistory[phase]); }
+	inline float getMaxPhaseMs(ProfilePhase phase) const { return maximum(phaseHistory[phase]); }
+	inline float getAverageGpuPassMs(GpuPass pass) const { return average(gpuPassHistory[pass]); }
+	inline float getMaxGpuPassMs(GpuPass pass) const { return maximum(gpuPassHistory[pass]); }
+
+	//whichever side takes longer per frame limits the frame rate, if neither is close to the frame time the swapchain (vsync) is
+	const char* getBottleneck() const
+	{
+		float frame = getAverageFrameMs();
+		float cpu = getAverageCpuBusyMs();
+		float gpu = getAverageGpuMs();
+
+		if (cpu < 0.75f * frame && gpu < 0.75f * frame) return "Present bound (vsync)";
+		return gpu > cpu ? "GPU bound" : "CPU bound";
+	}
+
+private:
+	float average(const float* history) const
+	{
+		if (framesRecorded == 0) return 0.0f;
+
+		float sum = 0.0f;
+		for (uint32_t i = 0; i < framesRecorded; ++i) sum += history[i];
+		return sum / framesRecorded;
+	}
+
+	float maximum(const float* history) const
+	{
+		float result = 0.0f;
+		for (uint32_t i = 0; i < framesRecorded; ++i) if (history[i] > result) result = history[i];
+		return result;
+	}
+};
+
+//times its own lifetime and adds it to a phase of the current frame
+class ProfileScope
+{
+	Profiler& profiler;
+	ProfilePhase phase;
+	std::chrono::high_resolution_clock::time_point start;
+
+public:
+	ProfileScope(Profiler& _profiler, ProfilePhase _phase) : profiler(_profiler), phase(_phase), start(std::chrono::high_resolution_clock::now()) {}
+
+	~ProfileScope()
+	{
+		profiler.AddPhaseTime(phase, std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <map>
+#include <iterator>
+#include <stdint.h>
+
+//hands out ranges of [0, capacity) (vertices, indices, bytes...), first fit, freed ranges are merged with their neighbours
+class RangeAllocator
+{
+	std::map<uint32_t, uint32_t> freeRanges; //offset -> count, never two touching ranges
+	uint32_t capacity = 0;
+	uint32_t used = 0;
+
+public:
+	static const uint32_t INVALID = UINT32_MAX;
+
+	RangeAllocator(uint32_t _capacity = 0) { Grow(_capacity); }
+
+	inline uint32_t getCapacity() const { return capacity; }
+	inline uint32_t getUsed() const { return used; }
+
+	//returns the offset of count free units, or INVALID if no free range is big enough
+	uint32_t Allocate(uint32_t count)
+	{
+		if (count == 0) return 0;
+
+		for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it)
+		{
+			if (it->second < count) continue;
+
+			uint32_t offset = it->first;
+			uint32_t remaining = it->second - count;
+			freeRanges.erase(it);
+			if (remaining > 0) freeRanges.emplace(offset + count, remaining);
+
+			used += count;
+			return offset;
+		}
+
+		return INVALID;
+	}
+
+	void Free(uint32_t offset, uint32_t count)
+	{
+		if (count == 0) return;
+		used -= count;
+
+		auto next = freeRanges.lower_bound(offset);
+		if (next != freeRanges.end() && offset + count == next->first)
+		{
+			count += next->second;
+			next = freeRanges.erase(next);
+		}
+
+		if (next != freeRanges.begin())
+		{
+			auto previous = std::prev(next);
+			if (previous->first + previous->second == offset)
+			{
+				previous->second += count;
+				return;
+			}
+		}
+
+		freeRanges.emplace(offset, count);
+	}
+
+	//the new units at the end are free
+	void Grow(uint32_t newCapacity)
+	{
+		if (newCapacity <= capacity) return;
+
+		uint32_t added = newCapacity - capacity;
+		uint32_t offset = capacity;
+		capacity = newCapacity;
+
+		used += added; //Free takes them back out
+		Free(offset, added);
+	}
+};
@@ -14,10 +14,16 @@
 #include "vulkanHandlers/GraphicsPipelineHandler.h"
 #include "vulkanHandlers/CommandBuffersHandler.h"
 #include "vulkanHandlers/DepthResourcesHandler.h"
+#include "vulkanHandlers/OffscreenTargetHandler.h"
+#include "vulkanHandlers/TimestampQueryHandler.h"
+#include "vulkanHandlers/DeletionQueueHandler.h"
+#include "vulkanHandlers/IndirectDrawBuffers.h"
 
 #include "ECS/Scene.h"
 #include "Vertex.h"
 #include "Camera.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
 
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
@@ -38,16 +44,46 @@ static void processInput(GLFWwindow*);
 class Renderer
 {
 public:
-	Renderer() { init(); }
+	//headless renders into offscreen images instead of a window, no surface, swapchain or ImGui (works with software drivers like lavapipe)
+	Renderer(bool _headless = false) : headless(_headless) { init(); }
 
 	Camera* camera;
 	bool framebufferResized = false;
 
 	Scene* scene;
 
-	GLFWwindow* getWindowPointer() { return windowHandler->getWindowPointer(); }
+	GLFWwindow* getWindowPointer() { return headless ? nullptr : windowHandler->getWindowPointer(); }
 	DeviceHandler* getDeviceHandler() { return deviceHandler; }
 	CommandBuffersHandler* getCommandBuffersHandler() { return commandBuffersHandler;  }
+	ThreadPool* getThreadPool() { return threadPool; }
+	DeletionQueueHandler* getDeletionQueue() { return deletionQueue; } //for Scene::FinishScene once frames are in flight
+	inline bool isHeadless() { return headless; }
+	inline Profiler& getProfiler() { return profiler; }
+	inline VkExtent2D& getRenderExtent() { return headless ? offscreenTargetHandler->getExtent() : swapchainHandler->getSwapchainExtent(); }
+
+	//when on, the scene's secondary command buffers are recorded once per frame in flight and reused until the scene
+	//or swapchain changes, only the primary and the overlay are recorded every frame
+	inline bool getCommandBufferReuse() { return reuseSceneCommands; }
+	void setCommandBufferReuse(bool reuse) { reuseSceneCommands = reuse; invalidateRecordedCommands(); }
+	//when on (and the device supports multiDrawIndirect), each recording task draws its slice of the scene's ranges with one
+	//vkCmdDrawIndexedIndirect instead of one vkCmdDrawIndexed per range
+	inline bool getIndirectDraws() { return useIndirectDraws && deviceHandler->hasMultiDrawIndirect(); }
+	void setIndirectDraws(bool indirect) { useIndirectDraws = indirect; invalidateRecordedCommands(); }
+	//forces the scene's draws to be recorded again, for changes the renderer can't detect on its own
+	void invalidateRecordedCommands() { for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) recordedScene[i] = nullptr; }
+
+	//frame pacing, the present mode and frame count take effect at the start of the next frame
+	//fewer frames in flight and latency mode trade throughput for responsiveness, see getProfiler().getAverageLatencyMs()
+	void setPresentMode(VkPresentModeKHR mode) { pendingPresentMode = mode; }
+	void setFramesInFlight(uint32_t count) { pendingFramesInFlight = std::clamp(count, 1u, (uint32_t)MAX_FRAMES_IN_FLIGHT); }
+	//samples input and updates the UBO after recording, right before submit, instead of right after the fence wait
+	inline void setLowLatencyMode(bool enabled) { lowLatencyMode = enabled; }
+	inline VkPresentModeKHR getPresentMode() { return headless ? VK_PRESENT_MODE_FIFO_KHR : swapchainHandler->getPresentMode(); }
+	inline uint32_t getFramesInFlight() { return framesInFlight; }
+	inline bool getLowLatencyMode() { return lowLatencyMode; }
+	//when off, keyboard and mouse leave the camera alone, for scripted camera paths that place it every frame
+	inline void setCameraInput(bool enabled) { cameraInput = enabled; }
+	inline bool getCameraInput() { return cameraInput; }
 	
 	void doLoop()
 	{
@@ -62,11 +98,22 @@ public:
 			previousTimepoint = now;
 		}
 
-		glfwPollEvents();
+		if (!headless) glfwPollEvents();
 		drawFrame();
+		profiler.EndFrame();
 		++framesRendered;
 	}
 
+	//headless only, waits for the most recently submitted frame and writes it to path as a PPM
+	void saveFrame(const char* path)
+	{
+		if (!headless) throw std::runtime_error("Frames can only be saved when rendering headless.\n");
+
+		uint32_t lastFrame = (currentFrame + framesInFlight - 1) % framesInFlight;
+		vkWaitForFences(deviceHandler->getLogicalDevice(), 1, &inFlightFences[lastFrame], VK_TRUE, UINT64_MAX);
+		offscreenTargetHandler->SaveFrame(lastFrame, path, commandBuffersHandler);
+	}
+
 	void terminate() 
 	{
 		vkDeviceWaitIdle(deviceHandler->getLogicalDevice()); //prevent premature closure while the device is finishing up
@@ -78,6 +125,107 @@ public:
 #ifdef DEBUG
 		ImGui::Text("FPS: %.1f", fps);
 
+		bool reuse = reuseSceneCommands;
+		if (ImGui::Checkbox("Reuse scene command buffers", &reuse)) setCommandBufferReuse(reuse);
+
+		if (deviceHandler->hasMultiDrawIndirect())
+		{
+			bool indirect = useIndirectDraws;
+			if (ImGui::Checkbox("Multi-draw indirect", &indirect)) setIndirectDraws(indirect);
+		}
+
+		if (ImGui::CollapsingHeader("Frame pacing"))
+		{
+			const VkPresentModeKHR presentModes[] = { VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+			const char* presentModeNames[] = { "FIFO (vsync)", "Mailbox", "Immediate" };
+
+			int presentMode = 0;
+			for (int i = 0; i < 3; ++i) if (presentModes[i] == getPresentMode()) presentMode = i;
+			if (ImGui::Combo("Present mode", &presentMode, presentModeNames, 3))
+			{
+				if (swapchainHandler->isPresentModeSupported(presentModes[presentMode])) setPresentMode(presentModes[presentMode]);
+			}
+
+			int frames = (int)framesInFlight;
+			if (ImGui::SliderInt("Frames in flight", &frames, 1, MAX_FRAMES_IN_FLIGHT)) setFramesInFlight((uint32_t)frames);
+
+			ImGui::Checkbox("Latency mode (late input)", &lowLatencyMode);
+
+			ImGui::Text("Input to present %.2f ms avg, %.2f ms max", profiler.getAverageLatencyMs(), profiler.getMaxLatencyMs());
+			ImGui::PlotLines("Latency", profiler.getLatencyHistory(), Profiler::HISTORY_SIZE, profiler.getHistoryOffset(), nullptr, 0.0f, 2.0f * profiler.getMaxLatencyMs(), ImVec2(0.0f, 50.0f));
+		}
+
+		if (ImGui::CollapsingHeader("Edit voxels"))
+		{
+			ImGui::InputInt3("Cell", editCell);
+			ImGui::InputInt3("Box max", editBoxMax);
+			ImGui::ColorEdit3("Color", editColor);
+			ImGui::SliderInt("Emission", &editEmission, 0, LightEngine::MAX_LIGHT);
+
+			glm::ivec3 cell(editCell[0], editCell[1], editCell[2]);
+			glm::ivec3 boxMax(editBoxMax[0], editBoxMax[1], editBoxMax[2]);
+			glm::vec3 color(editColor[0], editColor[1], editColor[2]);
+			if (ImGui::Button("Set")) scene->SetVoxel(cell, color, MATERIAL_NONE, (uint32_t)editEmission);
+			ImGui::SameLine();
+			if (ImGui::Button("Remove")) scene->RemoveVoxel(cell);
+			ImGui::SameLine();
+			if (ImGui::Button("Fill box")) scene->FillBox(glm::min(cell, boxMax), glm::max(cell, boxMax), color, MATERIAL_NONE, (uint32_t)editEmission);
+			ImGui::SameLine();
+			if (ImGui::Button("Clear box")) scene->FillBox(glm::min(cell, boxMax), glm::max(cell, boxMax), GridVoxel());
+
+			bool faceCulling = scene->GetChunkFaceCulling();
+			if (ImGui::Checkbox("Skip chunk faces facing away", &faceCulling)) scene->SetChunkFaceCulling(faceCulling);
+			bool caveCulling = scene->GetChunkCaveCulling();
+			if (ImGui::Checkbox("Skip chunks hidden from the camera's chunk", &caveCulling)) scene->SetChunkCaveCulling(caveCulling);
+			bool gpuMeshing = scene->GetGpuMeshing();
+			if (ImGui::Checkbox("Mesh chunks on the GPU", &gpuMeshing)) scene->SetGpuMeshing(gpuMeshing);
+
+			ImGui::Text("%zu chunks (%u hidden) in %zu draws, %u remeshed by the last update", scene->GetChunkCount(), scene->GetHiddenChunkCount(), scene->GetChunkDrawCount(), scene->GetLastRemeshCount());
+			ImGui::Text("Chunk uploads: %s", scene->AreChunksWrittenDirectly() ? "written to mapped device memory" : "staged");
+		}
+
+		if (ImGui::CollapsingHeader("Profiler", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			float frameMs = profiler.getAverageFrameMs();
+			ImGui::Text("Frame %.2f ms, CPU busy %.2f ms, GPU %.2f ms", frameMs, profiler.getAverageCpuBusyMs(), profiler.getAverageGpuMs());
+			ImGui::Text("%s", profiler.getBottleneck());
+
+			//same scale for both graphs so they can be compared directly
+			float graphMax = 2.0f * frameMs;
+			ImGui::PlotLines("CPU frame", profiler.getFrameHistory(), Profiler::HISTORY_SIZE, profiler.getHistoryOffset(), nullptr, 0.0f, graphMax, ImVec2(0.0f, 50.0f));
+			if (timestampQueries->isSupported())
+				ImGui::PlotLines("GPU frame", profiler.getGpuHistory(), Profiler::HISTORY_SIZE, profiler.getHistoryOffset(), nullptr, 0.0f, graphMax, ImVec2(0.0f, 50.0f));
+
+			if (ImGui::BeginTable("Scopes", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+			{
+				ImGui::TableSetupColumn("Scope");
+				ImGui::TableSetupColumn("Avg ms");
+				ImGui::TableSetupColumn("Max ms");
+				ImGui::TableHeadersRow();
+
+				for (uint32_t i = 0; i < PHASE_COUNT; ++i)
+				{
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn(); ImGui::Text("CPU %s", PROFILE_PHASE_NAMES[i]);
+					ImGui::TableNextColumn(); ImGui::Text("%.3f", profiler.getAveragePhaseMs((ProfilePhase)i));
+					ImGui::TableNextColumn(); ImGui::Text("%.3f", profiler.getMaxPhaseMs((ProfilePhase)i));
+				}
+
+				if (timestampQueries->isSupported())
+				{
+					for (uint32_t i = 0; i < GPU_PASS_COUNT; ++i)
+					{
+						ImGui::TableNextRow();
+						ImGui::TableNextColumn(); ImGui::Text("GPU %s", GPU_PASS_NAMES[i]);
+						ImGui::TableNextColumn(); ImGui::Text("%.3f", profiler.getAverageGpuPassMs((GpuPass)i));
+						ImGui::TableNextColumn(); ImGui::Text("%.3f", profiler.getMaxGpuPassMs((GpuPass)i));
+					}
+				}
+
+				ImGui::EndTable();
+			}
+		}
+
 		glm::vec3& pos = camera->getPos();
 		ImGui::Text("Position");
 		ImGui::Text("\tX: %.3f", pos.x);
@@ -106,25 +254,61 @@ public:
 	}
 
 private:
+	const bool headless;
 	uint32_t currentFrame = 0;
 
+	uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+	uint32_t pendingFramesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+	VkPresentModeKHR pendingPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+	bool lowLatencyMode = false;
+	bool cameraInput = true;
+
+	//when each frame's input was sampled, the latency is read once its fence has signaled
+	std::chrono::high_resolution_clock::time_point inputTimepoints[MAX_FRAMES_IN_FLIGHT];
+	bool latencyPending[MAX_FRAMES_IN_FLIGHT] = {};
+
+	//the ImGui voxel editing panel's inputs
+	int editCell[3] = {};
+	int editBoxMax[3] = {};
+	float editColor[3] = { 1.0f, 1.0f, 1.0f };
+	int editEmission = 0;
+
 	//for fps purposes
 	uint16_t framesRendered = 0;
 	std::chrono::steady_clock::time_point previousTimepoint = std::chrono::high_resolution_clock::now();
 	const std::chrono::seconds oneSecond = std::chrono::seconds(1);
 	float fps = 0;
 
+	Profiler profiler;
+	TimestampQueryHandler* timestampQueries;
+
+	ThreadPool* threadPool; //records the scene's draw ranges into secondary command buffers
+
+	//what each frame's scene secondaries were last recorded against, see setCommandBufferReuse
+	bool reuseSceneCommands = true;
+	Scene* recordedScene[MAX_FRAMES_IN_FLIGHT] = {};
+	uint64_t recordedSceneVersion[MAX_FRAMES_IN_FLIGHT] = {};
+	uint32_t recordedSwapchainGeneration[MAX_FRAMES_IN_FLIGHT] = {};
+	uint32_t recordedTaskCount[MAX_FRAMES_IN_FLIGHT] = {};
+
+	bool useIndirectDraws = true;
+	IndirectDrawBuffers* indirectDraws; //the draw ranges as indirect commands, see setIndirectDraws
+
     const std::vector<const char*> validationLayers = {
         "VK_LAYER_KHRONOS_validation"
     };
 	
-	WindowHandler* windowHandler;
+	WindowHandler* windowHandler = nullptr;
 	InstanceHandler* instanceHandler;
-	SurfaceHandler* surfaceHandler;
+	SurfaceHandler* surfaceHandler = nullptr;
     DeviceHandler* deviceHandler;
-	SwapchainHandler* swapchainHandler;
+	SwapchainHandler* swapchainHandler = nullptr;
+	DeletionQueueHandler* deletionQueue;
+	uint64_t submittedFrameNumbers[MAX_FRAMES_IN_FLIGHT] = {}; //what deletionQueue numbered each frame's last submit
+	OffscreenTargetHandler* offscreenTargetHandler = nullptr; //replaces the window, surface and swapchain when headless
 	RenderPassHandler* renderPassHandler;
 	DescriptorSetsHandler* descriptorSets;
+	ObjectBuffers* objectBuffers; //the scene's per object model matrices
 	GraphicsPipelineHandler* graphicsPipelineHandler;
 	CommandBuffersHandler* commandBuffersHandler;
 
@@ -144,7 +328,18 @@ private:
 	void createSyncObjects();
 
 	void drawFrame();
+	void drawFrameHeadless();
+	void waitForFrame(); //waits on the current frame's fence and collects its GPU timings
+	void applyFramePacing();
+	void sampleInput(); //input and UBO update, placed according to lowLatencyMode
+	void collectLatency();
+	void reserveObjectBuffer(); //before recording, growing the buffer invalidates recorded command buffers
+	void updateObjectBuffer();
+	void updateChunks(); //after anything that collects the whole deletion queue, it defers resources this frame still uses
 	void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+	void writeIndirectDraws(); //the current frame's indirect commands, while its scene secondaries are recorded again
+	void recordSceneCommands(VkCommandBuffer commandBuffer, VkCommandBufferInheritanceInfo& inheritanceInfo, uint32_t firstRange, uint32_t lastRange, bool indirect);
+	void recordOverlayCommands(VkCommandBuffer commandBuffer, VkCommandBufferInheritanceInfo& inheritanceInfo);
 };
 
 static void framebufferResizeCallback(GLFWwindow* window, int width, int height){
@@ -154,16 +349,24 @@ static void framebufferResizeCallback(GLFWwindow* window, int width, int height)
 
 static void processInput(GLFWwindow* window) {
 	//call InputCallback on the window's render's camera
-	reinterpret_cast<Renderer*>(glfwGetWindowUserPointer(window))->camera->InputCallback(window);
+	Renderer* renderer = reinterpret_cast<Renderer*>(glfwGetWindowUserPointer(window));
+	if (renderer->getCameraInput()) renderer->camera->InputCallback(window);
 }
 
 static void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 	//call MouseCallback on the window's render's camera
-	reinterpret_cast<Renderer*>(glfwGetWindowUserPointer(window))->camera->MouseCallback((float) xpos, (float) ypos);
+	Renderer* renderer = reinterpret_cast<Renderer*>(glfwGetWindowUserPointer(window));
+	if (renderer->getCameraInput()) renderer->camera->MouseCallback((float) xpos, (float) ypos);
 }
 
 void Renderer::init()
 {
+	if (headless)
+	{
+		initVulkan();
+		return;
+	}
+
 	windowHandler = new WindowHandler();
 	GLFWwindow* window = windowHandler->getWindowPointer();
 
@@ -177,21 +380,35 @@ void Renderer::init()
 }
 
 void Renderer::initVulkan() {
-	instanceHandler = new InstanceHandler(validationLayers);
-	surfaceHandler = new SurfaceHandler(instanceHandler, windowHandler);
+	instanceHandler = new InstanceHandler(validationLayers, headless);
+	if (!headless) surfaceHandler = new SurfaceHandler(instanceHandler, windowHandler);
 	deviceHandler = new DeviceHandler(instanceHandler, surfaceHandler, validationLayers);
 	VkDevice& logicalDevice = deviceHandler->getLogicalDevice();
+	deletionQueue = new DeletionQueueHandler();
 
-	swapchainHandler = new SwapchainHandler(windowHandler, surfaceHandler, deviceHandler);
-	renderPassHandler = new RenderPassHandler(logicalDevice, swapchainHandler->getSwapchainImageFormat(), swapchainHandler->findDepthFormat());
-	swapchainHandler->createInitialFrameBuffers(renderPassHandler);
+	if (headless)
+	{
+		offscreenTargetHandler = new OffscreenTargetHandler(deviceHandler, WIDTH, HEIGHT);
+		renderPassHandler = new RenderPassHandler(logicalDevice, offscreenTargetHandler->getColorFormat(), offscreenTargetHandler->findDepthFormat(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+		offscreenTargetHandler->createInitialFrameBuffers(renderPassHandler);
+	}
+	else
+	{
+		swapchainHandler = new SwapchainHandler(windowHandler, surfaceHandler, deviceHandler, deletionQueue);
+		renderPassHandler = new RenderPassHandler(logicalDevice, swapchainHandler->getSwapchainImageFormat(), swapchainHandler->findDepthFormat());
+		swapchainHandler->createInitialFrameBuffers(renderPassHandler);
+	}
 
-	commandBuffersHandler = new CommandBuffersHandler(deviceHandler);
-	camera = new Camera(deviceHandler, swapchainHandler);
-	texture = new TextureHandler(TEXTURE_PATH, deviceHandler, commandBuffersHandler);
-	descriptorSets = new DescriptorSetsHandler(logicalDevice, camera->getUniformBuffers(), texture);
+	threadPool = new ThreadPool();
+	commandBuffersHandler = new CommandBuffersHandler(deviceHandler, threadPool->getWorkerCount());
+	timestampQueries = new TimestampQueryHandler(deviceHandler);
+	indirectDraws = new IndirectDrawBuffers(deviceHandler);
+	camera = new Camera(deviceHandler, getRenderExtent());
+	texture = new TextureHandler(MATERIAL_TEXTURE_PATHS, deviceHandler, commandBuffersHandler);
+	objectBuffers = new ObjectBuffers(deviceHandler);
+	descriptorSets = new DescriptorSetsHandler(logicalDevice, camera->getUniformBuffers(), objectBuffers, texture);
 
-	graphicsPipelineHandler = new GraphicsPipelineHandler(logicalDevice, swapchainHandler, descriptorSets->getDescriptorSetLayout(), renderPassHandler->getRenderPass());
+	graphicsPipelineHandler = new GraphicsPipelineHandler(logicalDevice, getRenderExtent(), descriptorSets->getDescriptorSetLayout(), renderPassHandler->getRenderPass());
 
 	createSyncObjects();
 
@@ -232,19 +449,25 @@ void Renderer::initImGui()
 void Renderer::cleanup()
 {
 #ifdef DEBUG
-	ImGui_ImplVulkan_DestroyFontsTexture();
-	ImGui_ImplVulkan_Shutdown();
-	ImGui_ImplGlfw_Shutdown();
-	ImGui::DestroyContext();
+	if (!headless)
+	{
+		ImGui_ImplVulkan_DestroyFontsTexture();
+		ImGui_ImplVulkan_Shutdown();
+		ImGui_ImplGlfw_Shutdown();
+		ImGui::DestroyContext();
+	}
 #endif
 
 	VkDevice& device = deviceHandler->getLogicalDevice();
 
+	delete deletionQueue; //the device is idle, anything still deferred (like a retired swapchain) is destroyed now
 	delete swapchainHandler;
+	delete offscreenTargetHandler;
 	delete graphicsPipelineHandler;
 	delete renderPassHandler;
 	delete camera;
 	delete descriptorSets;
+	delete objectBuffers;
 	delete texture;
 
 	scene->TerminateScene();
@@ -255,13 +478,16 @@ void Renderer::cleanup()
 		vkDestroyFence(device, inFlightFences[i], nullptr);
 	}
 
+	delete threadPool;
 	delete commandBuffersHandler;
+	delete timestampQueries;
+	delete indirectDraws;
 	delete deviceHandler;
 	delete surfaceHandler; //surface must be deleted before the instance
 	delete instanceHandler;
 	delete windowHandler;
 
-	glfwTerminate();
+	if (!headless) glfwTerminate();
 
 	std::cout << "Renderer successfully terminated.\n";
 }
@@ -291,12 +517,25 @@ void Renderer::createSyncObjects() {
 }
 
 void Renderer::drawFrame() {
+	if (headless)
+	{
+		drawFrameHeadless();
+		return;
+	}
+
 	VkDevice& device = deviceHandler->getLogicalDevice();
 
-	vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+	applyFramePacing();
+	waitForFrame();
+	reserveObjectBuffer();
+	updateChunks();
 
 	uint32_t imageIndex;
-	VkResult result = vkAcquireNextImageKHR(device, swapchainHandler->getSwapchain(), UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+	VkResult result;
+	{
+		ProfileScope scope(profiler, PHASE_ACQUIRE);
+		result = vkAcquireNextImageKHR(device, swapchainHandler->getSwapchain(), UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+	}
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR) {
 		swapchainHandler->recreateSwapchain();
@@ -306,12 +545,14 @@ void Renderer::drawFrame() {
 		throw std::runtime_error("failed to acquire swap chain image!");
 	}
 
-	processInput(windowHandler->getWindowPointer());
-	camera->Update(currentFrame); //updates UBOs
+	if (!lowLatencyMode) sampleInput();
 
-	recordCommandBuffer(commandBuffersHandler->GetCommandBuffers()[currentFrame], imageIndex);
+	{
+		ProfileScope scope(profiler, PHASE_RECORD);
+		recordCommandBuffer(commandBuffersHandler->GetCommandBuffers()[currentFrame], imageIndex);
+	}
 
-	vkResetFences(device, 1, &inFlightFences[currentFrame]);
+	if (lowLatencyMode) sampleInput(); //the recorded commands don't depend on the UBO contents
 
 	//vkResetCommandBuffer(commandBuffersHandler->GetCommandBuffers()[currentFrame], /*VkCommandBufferResetFlagBits*/ 0);
 
@@ -331,8 +572,14 @@ void Renderer::drawFrame() {
 	submitInfo.signalSemaphoreCount = 1;
 	submitInfo.pSignalSemaphores = signalSemaphores;
 
-	if (vkQueueSubmit(deviceHandler->getGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
-		throw std::runtime_error("failed to submit draw command buffer!");
+	{
+		ProfileScope scope(profiler, PHASE_SUBMIT);
+		vkResetFences(device, 1, &inFlightFences[currentFrame]);
+
+		if (vkQueueSubmit(deviceHandler->getGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit draw command buffer!");
+		submittedFrameNumbers[currentFrame] = deletionQueue->FrameSubmitted();
+	}
 
 	VkPresentInfoKHR presentInfo{};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -346,7 +593,10 @@ void Renderer::drawFrame() {
 
 	presentInfo.pImageIndices = &imageIndex;
 
-	result = vkQueuePresentKHR(deviceHandler->getPresentQueue(), &presentInfo);
+	{
+		ProfileScope scope(profiler, PHASE_PRESENT);
+		result = vkQueuePresentKHR(deviceHandler->getPresentQueue(), &presentInfo);
+	}
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) {
 		framebufferResized = false;
@@ -356,10 +606,145 @@ void Renderer::drawFrame() {
 		throw std::runtime_error("failed to present swap chain image!");
 	}
 
-	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+	currentFrame = (currentFrame + 1) % framesInFlight;
+}
+
+void Renderer::waitForFrame() {
+	{
+		ProfileScope scope(profiler, PHASE_FENCE_WAIT);
+		vkWaitForFences(deviceHandler->getLogicalDevice(), 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+	}
+
+	float gpuPassMs[GPU_PASS_COUNT];
+	float gpuMs;
+	if (timestampQueries->ReadResults(currentFrame, gpuPassMs, gpuMs)) profiler.SetGpuTimings(gpuPassMs, gpuMs);
+
+	deletionQueue->Collect(submittedFrameNumbers[currentFrame]);
+	collectLatency();
+}
+
+void Renderer::applyFramePacing() {
+	if (pendingFramesInFlight != framesInFlight)
+	{
+		//every frame's fence has signaled after this, so the slots can be remapped
+		vkDeviceWaitIdle(deviceHandler->getLogicalDevice());
+		deletionQueue->Collect(deletionQueue->getSubmittedFrames());
+		collectLatency();
+
+		framesInFlight = pendingFramesInFlight;
+		currentFrame = 0;
+	}
+
+	if (!headless) swapchainHandler->setPresentMode(pendingPresentMode); //only recreates the swapchain if the mode changed
+}
+
+void Renderer::sampleInput() {
+	{
+		ProfileScope scope(profiler, PHASE_INPUT);
+		if (!headless)
+		{
+			if (lowLatencyMode) glfwPollEvents(); //pick up mouse movement that arrived while recording
+			processInput(windowHandler->getWindowPointer());
+		}
+	}
+
+	inputTimepoints[currentFrame] = std::chrono::high_resolution_clock::now();
+	latencyPending[currentFrame] = true;
+
+	{
+		ProfileScope scope(profiler, PHASE_UBO_UPDATE);
+		camera->Update(currentFrame); //updates UBOs
+		updateObjectBuffer();
+	}
+}
+
+void Renderer::reserveObjectBuffer() {
+	uint32_t objectCount = scene->GetObjectCount();
+
+	if (objectCount > objectBuffers->getCapacity())
+	{
+		//rare, every frame's descriptor set points at the old buffers, so wait for all of them
+		vkDeviceWaitIdle(deviceHandler->getLogicalDevice());
+		deletionQueue->Collect(deletionQueue->getSubmittedFrames());
+
+		objectBuffers->Resize(std::max(objectCount, objectBuffers->getCapacity() * 2));
+		descriptorSets->UpdateObjectBuffers();
+		invalidateRecordedCommands(); //recorded descriptor set bindings are invalid once the sets are updated
+	}
+}
+
+void Renderer::updateObjectBuffer() {
+	scene->UpdateTransforms();
+	objectBuffers->Upload(currentFrame, scene->GetObjectMatrices(), scene->GetObjectCount(), scene->GetRenderInfo().transformVersion);
+}
+
+void Renderer::updateChunks() {
+	ProfileScope scope(profiler, PHASE_CHUNK_UPDATE);
+	scene->UpdateChunks(currentFrame, deletionQueue);
+	scene->CullChunks(camera->getPos());
+}
+
+//input to present is measured from sampling input until the frame's fence is seen signaled: rendering is done and
+//the image is queued for presentation, scanout isn't included. Polling every frame's fence keeps this from being
+//rounded up to the next time the CPU happens to wait on a frame
+void Renderer::collectLatency() {
+	auto now = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		if (!latencyPending[i] || vkGetFenceStatus(deviceHandler->getLogicalDevice(), inFlightFences[i]) != VK_SUCCESS) continue;
+
+		profiler.SetLatency(std::chrono::duration<float, std::milli>(now - inputTimepoints[i]).count());
+		latencyPending[i] = false;
+	}
+}
+
+//no acquire or present, frame n renders into offscreen image n, so the in flight fence is the only synchronization needed
+void Renderer::drawFrameHeadless() {
+	VkDevice& device = deviceHandler->getLogicalDevice();
+
+	applyFramePacing();
+	waitForFrame();
+	reserveObjectBuffer();
+	updateChunks();
+
+	if (!lowLatencyMode) sampleInput();
+
+	{
+		ProfileScope scope(profiler, PHASE_RECORD);
+		recordCommandBuffer(commandBuffersHandler->GetCommandBuffers()[currentFrame], currentFrame);
+	}
+
+	if (lowLatencyMode) sampleInput();
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffersHandler->GetCommandBuffers()[currentFrame];
+
+	{
+		ProfileScope scope(profiler, PHASE_SUBMIT);
+		vkResetFences(device, 1, &inFlightFences[currentFrame]);
+
+		if (vkQueueSubmit(deviceHandler->getGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit draw command buffer!");
+		submittedFrameNumbers[currentFrame] = deletionQueue->FrameSubmitted();
+	}
+
+	currentFrame = (currentFrame + 1) % framesInFlight;
 }
 
+//the primary buffer only begins the render pass and executes secondaries: one per worker with a slice of the scene's
+//draw ranges, recorded in parallel, then the overlay (ImGui), recorded on this thread in the meantime
+//the scene secondaries are skipped entirely when the ones from this frame's last use are still valid
 void Renderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+	RendererInfo& ri = scene->GetRenderInfo();
+	uint32_t swapchainGeneration = headless ? 0 : swapchainHandler->getGeneration();
+	bool recordScene = !reuseSceneCommands
+		|| recordedScene[currentFrame] != scene
+		|| recordedSceneVersion[currentFrame] != ri.version
+		|| recordedSwapchainGeneration[currentFrame] != swapchainGeneration;
+
 	VkCommandBufferBeginInfo beginInfo{};
 	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 	//optional
@@ -368,12 +753,16 @@ void Renderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t image
 
 	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) throw std::runtime_error("Failed to beign recording command buffer.\n");
 
+	timestampQueries->BeginFrame(commandBuffer, currentFrame);
+
+	scene->RecordChunkUploads(commandBuffer, currentFrame);
+
 	VkRenderPassBeginInfo renderPassInfo{};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 	renderPassInfo.renderPass = renderPassHandler->getRenderPass();
-	renderPassInfo.framebuffer = swapchainHandler->getSwapchainFramebuffers()[imageIndex];
+	renderPassInfo.framebuffer = headless ? offscreenTargetHandler->getFramebuffers()[imageIndex] : swapchainHandler->getSwapchainFramebuffers()[imageIndex];
 	renderPassInfo.renderArea.offset = { 0, 0 };
-	renderPassInfo.renderArea.extent = swapchainHandler->getSwapchainExtent();
+	renderPassInfo.renderArea.extent = getRenderExtent();
 
 	std::array<VkClearValue, 2> clearValues{};
 	clearValues[0] = { {0.0f, 0.0f, 0.0f, 1.0f} }; //color attachments
@@ -384,45 +773,196 @@ void Renderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t image
 
 	//to commandBuffer, record a BeginRenderPass command, using &renderPassInfo, into a primary command buffer
 	//all vkCmd functions return void; error handling is done after recording
-	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelineHandler->getGraphicsPipeline());
+	//secondaries need to know which render pass they will execute inside of
+	//the scene's leave the framebuffer out since they are reused with whichever swapchain image is acquired
+	VkCommandBufferInheritanceInfo sceneInheritanceInfo{};
+	sceneInheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	sceneInheritanceInfo.renderPass = renderPassInfo.renderPass;
+	sceneInheritanceInfo.subpass = 0;
+	sceneInheritanceInfo.framebuffer = VK_NULL_HANDLE;
 
-	VkBuffer vertexBuffers[] = { scene->GetRenderInfo().vertexBuffer};
-	VkDeviceSize offsets[] = { 0 };
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-	vkCmdBindIndexBuffer(commandBuffer, scene->GetRenderInfo().indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	VkCommandBufferInheritanceInfo overlayInheritanceInfo = sceneInheritanceInfo;
+	overlayInheritanceInfo.framebuffer = renderPassInfo.framebuffer;
+
+	if (recordScene)
+	{
+		//safe, waitForFrame has already waited on this frame's fence, which was the last use of these buffers
+		commandBuffersHandler->ResetThreadCommandPools(currentFrame);
+
+		//contiguous blocks of draw ranges per task so the draw order stays the same as recording on one thread
+		//the baked scene's ranges come first, then the chunks'
+		uint32_t rangeCount = static_cast<uint32_t>(ri.drawRanges.size() + ri.chunkDrawRanges.size());
+		uint32_t taskCount = std::min(commandBuffersHandler->GetThreadCount(), rangeCount);
+		uint32_t frame = currentFrame;
+
+		bool indirect = getIndirectDraws();
+		if (indirect) writeIndirectDraws();
+
+		//secondaries are per task rather than per worker, a worker may pick up more than one task
+		threadPool->Dispatch(taskCount, [&, frame, rangeCount, taskCount, indirect](uint32_t task, uint32_t) {
+			uint32_t first = rangeCount * task / taskCount;
+			uint32_t last = rangeCount * (task + 1) / taskCount;
+			recordSceneCommands(commandBuffersHandler->GetThreadCommandBuffer(frame, task), sceneInheritanceInfo, first, last, indirect);
+		});
+
+		recordedTaskCount[currentFrame] = taskCount;
+		recordedScene[currentFrame] = nullptr; //only marked valid once recording succeeded
+	}
+
+	VkCommandBuffer overlayCommandBuffer = commandBuffersHandler->GetOverlayCommandBuffer(currentFrame);
+	try { recordOverlayCommands(overlayCommandBuffer, overlayInheritanceInfo); }
+	catch (...)
+	{
+		if (recordScene) threadPool->Wait(); //the workers still reference this stack frame
+		throw;
+	}
+
+	if (recordScene)
+	{
+		threadPool->Wait();
+
+		recordedScene[currentFrame] = scene;
+		recordedSceneVersion[currentFrame] = ri.version;
+		recordedSwapchainGeneration[currentFrame] = swapchainGeneration;
+	}
+
+	uint32_t taskCount = recordedTaskCount[currentFrame];
+	std::vector<VkCommandBuffer> secondaries;
+	secondaries.reserve(taskCount + 1);
+	for (uint32_t task = 0; task < taskCount; ++task) secondaries.push_back(commandBuffersHandler->GetThreadCommandBuffer(currentFrame, task));
+	secondaries.push_back(overlayCommandBuffer);
+
+	vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+
+	vkCmdEndRenderPass(commandBuffer);
+
+	timestampQueries->EndPass(commandBuffer, currentFrame, GPU_PASS_IMGUI);
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) throw std::runtime_error("Failed to record command buffer!\n");
+}
+
+//one command per draw range, in the same order the ranges are split between the recording tasks
+//safe to overwrite, the frame's fence has signaled and its secondaries (the only readers) are about to be recorded again
+void Renderer::writeIndirectDraws() {
+	RendererInfo& ri = scene->GetRenderInfo();
+	uint32_t rangeCount = static_cast<uint32_t>(ri.drawRanges.size() + ri.chunkDrawRanges.size());
+	VkDrawIndexedIndirectCommand* commands = indirectDraws->Reserve(currentFrame, rangeCount);
+
+	auto write = [&](const std::vector<DrawRange>& ranges) {
+		for (const DrawRange& range : ranges)
+		{
+			VkDrawIndexedIndirectCommand command{};
+			command.indexCount = range.indexCount;
+			command.instanceCount = 1;
+			command.firstIndex = range.firstIndex;
+			command.vertexOffset = range.vertexOffset;
+			command.firstInstance = 0;
+			*commands++ = command;
+		}
+	};
+	write(ri.drawRanges);
+	write(ri.chunkDrawRanges);
+}
+
+//runs on a worker thread, only reads renderer state
+//ranges [firstRange, lastRange) index the baked scene's draw ranges followed by the chunks'
+//both sets are each bound once, every range is a base vertex draw into them with 16 bit indices
+void Renderer::recordSceneCommands(VkCommandBuffer commandBuffer, VkCommandBufferInheritanceInfo& inheritanceInfo, uint32_t firstRange, uint32_t lastRange, bool indirect) {
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT; //not one time submit, it may be executed again in later frames
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) throw std::runtime_error("Failed to begin recording secondary command buffer.\n");
+
+	//secondaries inherit no state from the primary, everything is bound again
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelineHandler->getGraphicsPipeline());
 
 	//these are the dynamic state things specified when creating the pipeline:
 	VkViewport viewport{};
 	viewport.x = 0.0f;
 	viewport.y = 0.0f;
-	viewport.width = static_cast<float>(swapchainHandler->getSwapchainExtent().width);
-	viewport.height = static_cast<float>(swapchainHandler->getSwapchainExtent().height);
+	viewport.width = static_cast<float>(getRenderExtent().width);
+	viewport.height = static_cast<float>(getRenderExtent().height);
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
 	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
 	VkRect2D scissor{};
 	scissor.offset = { 0, 0 };
-	scissor.extent = swapchainHandler->getSwapchainExtent();
+	scissor.extent = getRenderExtent();
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
 	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelineHandler->getPipelineLayout(), 0, 1, &descriptorSets->getDescriptorSets()[currentFrame], 0, nullptr);
-	vkCmdDrawIndexed(commandBuffer, scene->GetRenderInfo().numIndices, 1, 0, 0, 0);
+
+	RendererInfo& ri = scene->GetRenderInfo();
+	uint32_t bakedCount = static_cast<uint32_t>(ri.drawRanges.size());
+	VkDeviceSize offsets[] = { 0 };
+
+	if (firstRange < bakedCount)
+	{
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &ri.vertexBuffer, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, ri.indexBuffer, 0, VERTEX_INDEX_TYPE);
+
+		uint32_t last = std::min(lastRange, bakedCount);
+		if (indirect) indirectDraws->RecordDraws(commandBuffer, currentFrame, firstRange, last - firstRange);
+		else
+		{
+			for (uint32_t i = firstRange; i < last; ++i)
+			{
+				const DrawRange& range = ri.drawRanges[i];
+				vkCmdDrawIndexed(commandBuffer, range.indexCount, 1, range.firstIndex, range.vertexOffset, 0);
+			}
+		}
+	}
+
+	if (lastRange > bakedCount)
+	{
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &ri.chunkVertexBuffer, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, ri.chunkIndexBuffer, 0, VERTEX_INDEX_TYPE);
+
+		uint32_t first = std::max(firstRange, bakedCount);
+		if (indirect) indirectDraws->RecordDraws(commandBuffer, currentFrame, first, lastRange - first);
+		else
+		{
+			for (uint32_t i = first - bakedCount; i < lastRange - bakedCount; ++i)
+			{
+				const DrawRange& range = ri.chunkDrawRanges[i];
+				vkCmdDrawIndexed(commandBuffer, range.indexCount, 1, range.firstIndex, range.vertexOffset, 0);
+			}
+		}
+	}
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) throw std::runtime_error("Failed to record secondary command buffer!\n");
+}
+
+//executes after every scene secondary, so its first timestamp marks the end of the scene pass
+//(timestamps can't be written from the primary while it is inside a render pass with secondary contents)
+void Renderer::recordOverlayCommands(VkCommandBuffer commandBuffer, VkCommandBufferInheritanceInfo& inheritanceInfo) {
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) throw std::runtime_error("Failed to begin recording overlay command buffer.\n");
+
+	timestampQueries->EndPass(commandBuffer, currentFrame, GPU_PASS_SCENE);
 
 #ifdef DEBUG
-	ImGui_ImplVulkan_NewFrame();
-	ImGui_ImplGlfw_NewFrame();
-	ImGui::NewFrame();
+	if (!headless)
+	{
+		ImGui_ImplVulkan_NewFrame();
+		ImGui_ImplGlfw_NewFrame();
+		ImGui::NewFrame();
 
-	processImGui();
+		processImGui();
 
-	ImGui::Render();
-	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer, 0);
+		ImGui::Render();
+		ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer, 0);
+	}
 #endif
 
-	vkCmdEndRenderPass(commandBuffer);
-
-	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) throw std::runtime_error("Failed to record command buffer!\n");
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) throw std::runtime_error("Failed to record overlay command buffer!\n");
 }
\ No newline at end of file
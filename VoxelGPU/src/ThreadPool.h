@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <stdint.h>
+
+//fixed set of worker threads that run one batch of tasks at a time
+//Dispatch hands out tasks 0..taskCount-1, Wait blocks until all of them are done, so the caller can do its own work in between
+class ThreadPool
+{
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable workAvailable;
+	std::condition_variable workDone;
+
+	std::function<void(uint32_t task, uint32_t worker)> job;
+	uint32_t taskCount = 0;
+	std::atomic<uint32_t> nextTask{ 0 };
+	uint32_t tasksFinished = 0;
+	uint32_t activeWorkers = 0; //workers inside a batch, a new batch only starts once this is 0
+	uint64_t generation = 0; //bumped per Dispatch so sleeping workers know there is a new batch
+	bool stopping = false;
+
+	std::exception_ptr failure; //first exception thrown by a task, rethrown by Wait
+
+public:
+	//workerCount 0 picks one less than the number of hardware threads, leaving one for the main thread
+	ThreadPool(uint32_t workerCount = 0)
+	{
+		if (workerCount == 0)
+		{
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		for (uint32_t i = 0; i < workerCount; ++i) workers.emplace_back(&ThreadPool::workerLoop, this, i);
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		workAvailable.notify_all();
+		for (std::thread& worker : workers) worker.join();
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	inline uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+
+	//fn(task, worker) is called once per task on some worker, worker is in [0, getWorkerCount()) and never runs two tasks at once
+	void Dispatch(uint32_t _taskCount, std::function<void(uint32_t, uint32_t)> fn)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			//a worker that woke up late for the previous batch may still be looking for tasks
+			workDone.wait(lock, [this]() { return activeWorkers == 0; });
+
+			job = std::move(fn);
+			taskCount = _taskCount;
+			tasksFinished = 0;
+			nextTask.store(0);
+			failure = nullptr;
+			++generation;
+		}
+		workAvailable.notify_all();
+	}
+
+	void Wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		workDone.wait(lock, [this]() { return tasksFinished == taskCount && activeWorkers == 0; });
+
+		if (failure)
+		{
+			std::exception_ptr e = failure;
+			failure = nullptr;
+			std::rethrow_exception(e);
+		}
+	}
+
+	inline void ParallelFor(uint32_t _taskCount, std::function<void(uint32_t, uint32_t)> fn)
+	{
+		Dispatch(_taskCount, std::move(fn));
+		Wait();
+	}
+
+private:
+	void workerLoop(uint32_t workerIndex)
+	{
+		uint64_t seenGeneration = 0;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				workAvailable.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+				if (stopping) return;
+				seenGeneration = generation;
+				++activeWorkers;
+			}
+
+			uint32_t finished = 0;
+			for (uint32_t task = nextTask.fetch_add(1); task < taskCount; task = nextTask.fetch_add(1))
+			{
+				try { job(task, workerIndex); }
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if (!failure) failure = std::current_exception();
+				}
+				++finished;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				tasksFinished += finished;
+				--activeWorkers;
+				if (activeWorkers == 0) workDone.notify_all();
+			}
+		}
+	}
+};
@@ -8,10 +8,30 @@
 #include <glm/gtx/hash.hpp>
 #include <glm/glm.hpp>
 
+//material IDs index the texture array layers (offset by one), this one means "vertex color only"
+const uint32_t MATERIAL_NONE = 0;
+
+//every mesh is drawn with a base vertex (DrawRange::vertexOffset), so its indices only count from its own first vertex and fit in 16 bits
+typedef uint16_t VertexIndex;
+const VkIndexType VERTEX_INDEX_TYPE = VK_INDEX_TYPE_UINT16;
+const uint32_t MAX_VERTICES_PER_DRAW = 1 << 16;
+
+//8 bits per channel, red in the lowest byte and the top byte left 0, how voxels store their color (vertices carry floats)
+inline uint32_t PackColor(const glm::vec3& color){
+	glm::vec3 c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+	return static_cast<uint32_t>(c.r) | (static_cast<uint32_t>(c.g) << 8) | (static_cast<uint32_t>(c.b) << 16);
+}
+
+inline glm::vec3 UnpackColor(uint32_t color){
+	return glm::vec3(float(color & 0xFF), float((color >> 8) & 0xFF), float((color >> 16) & 0xFF)) * (1.0f / 255.0f);
+}
+
 struct Vertex{
 	glm::vec3 pos;
 	glm::vec3 color;
 	glm::vec2 texCoord;
+	uint32_t materialId = MATERIAL_NONE;
+	uint32_t objectIndex = 0; //which model matrix the vertex shader applies, see ObjectBuffers
 
 	static VkVertexInputBindingDescription getBindingDescription(){
 		VkVertexInputBindingDescription bindingDescription{};
@@ -22,8 +42,8 @@ struct Vertex{
 		return bindingDescription;
 	}
 
-	static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
-        std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+	static std::array<VkVertexInputAttributeDescription, 5> getAttributeDescriptions() {
+        std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions{};
 
         attributeDescriptions[0].binding = 0;
         attributeDescriptions[0].location = 0;
@@ -40,11 +60,21 @@ struct Vertex{
         attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
         attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
 
+        attributeDescriptions[3].binding = 0;
+        attributeDescriptions[3].location = 3;
+        attributeDescriptions[3].format = VK_FORMAT_R32_UINT;
+        attributeDescriptions[3].offset = offsetof(Vertex, materialId);
+
+        attributeDescriptions[4].binding = 0;
+        attributeDescriptions[4].location = 4;
+        attributeDescriptions[4].format = VK_FORMAT_R32_UINT;
+        attributeDescriptions[4].offset = offsetof(Vertex, objectIndex);
+
         return attributeDescriptions;
     }
 
     bool operator==(const Vertex& other) const {
-        return pos == other.pos && color == other.color && texCoord == other.texCoord;
+        return pos == other.pos && color == other.color && texCoord == other.texCoord && materialId == other.materialId && objectIndex == other.objectIndex;
     }
 };
 
@@ -52,7 +82,7 @@ struct Vertex{
 namespace std {
     template<> struct hash<Vertex> {
         size_t operator()(Vertex const& vertex) const {
-            return ((hash<glm::vec3>()(vertex.pos) ^ (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ (hash<glm::vec2>()(vertex.texCoord) << 1);
+            return (((hash<glm::vec3>()(vertex.pos) ^ (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ (hash<glm::vec2>()(vertex.texCoord) << 1)) ^ hash<uint32_t>()(vertex.materialId);
         }
     };
 }
\ No newline at end of file
@@ -1,38 +1,71 @@
 #include "Renderer.h"
 #include "ECS/Scene.h"
-#include <random>
+#include <string>
+#include <cstring>
+#include <cstdio>
+
+//usage: VoxelGPU [--headless <frames>] [--dump <directory>] [--gpu-meshing] [--gpu-terrain]
+//--headless renders the given number of frames offscreen and exits, --dump writes each of them to <directory>/frame_NNNN.ppm
+//--gpu-meshing meshes the chunks with a compute shader, --gpu-terrain generates the terrain with one, the frames are the
+//same as without them
+int main(int argc, char** argv){
+	bool headless = false;
+	uint32_t headlessFrames = 1;
+	const char* dumpDirectory = nullptr;
+	bool gpuMeshing = false;
+	bool gpuTerrain = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--headless") == 0)
+		{
+			headless = true;
+			if (i + 1 < argc && argv[i + 1][0] != '-') headlessFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) dumpDirectory = argv[++i];
+		else if (strcmp(argv[i], "--gpu-meshing") == 0) gpuMeshing = true;
+		else if (strcmp(argv[i], "--gpu-terrain") == 0) gpuTerrain = true;
+		else
+		{
+			std::cerr << "Unknown argument: " << argv[i] << '\n';
+			return EXIT_FAILURE;
+		}
+	}
 
-int main(){
 	try 
 	{
-		Renderer renderer;
+		Renderer renderer(headless);
 		GLFWwindow* window;
 
 		window = renderer.getWindowPointer();
 
-		Scene scene(renderer.getDeviceHandler(), renderer.getCommandBuffersHandler());
+		Scene scene(renderer.getDeviceHandler(), renderer.getCommandBuffersHandler(), renderer.getThreadPool());
+		scene.SetGpuMeshing(gpuMeshing);
+		scene.SetGpuTerrain(gpuTerrain);
 
-		std::linear_congruential_engine<std::uint_fast32_t, 16807, 0, 2147483647> lce;
-		glm::vec3 white(1.0f);
-		glm::vec3 blue(0.0f, 0.0f, 1.0f);
+		//terrain in front of the camera, from -128 to 127 cells on x and 0 to 255 on z, the surface is below the camera
+		TerrainGenerator::Settings terrain;
+		terrain.Seed = 1337;
+		scene.GenerateTerrain(TerrainGenerator(terrain), glm::ivec3(-8, -4, 0), glm::ivec3(7, 0, 15));
 
-		unsigned int num = 0;
-		for (float x = 0.0f; x < 10.0f; x += 0.1f)
+		scene.FinishScene();
+		renderer.scene = &scene;
+
+		if (headless)
 		{
-			for (float z = 0.0f; z < 10.0f; z += 0.1f)
+			for (uint32_t frame = 0; frame < headlessFrames; ++frame)
 			{
-				glm::vec3 position(x, 0.0f, z);
-				if(num % 2 == 0) scene.AddVoxel(TransformComponent(position), white);
-				else scene.AddVoxel(TransformComponent(position), blue);
-				++num;
+				renderer.doLoop();
+
+				if (dumpDirectory != nullptr)
+				{
+					char fileName[32];
+					snprintf(fileName, sizeof(fileName), "/frame_%04u.ppm", frame);
+					renderer.saveFrame((std::string(dumpDirectory) + fileName).c_str());
+				}
 			}
-			++num;
 		}
-
-		scene.FinishScene();
-		renderer.scene = &scene;
-
-		while (!glfwWindowShouldClose(window))
+		else while (!glfwWindowShouldClose(window))
 		{
 			renderer.doLoop();
 		}
@@ -42,10 +42,65 @@ namespace BufferHelpers {
         allocInfo.allocationSize = memRequirements.size;
         allocInfo.memoryTypeIndex = BufferHelpers::FindMemoryType(memRequirements.memoryTypeBits, properties, deviceHandler);
 
-        if(vkAllocateMemory(deviceHandler->getLogicalDevice(), &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) throw std::runtime_error("Failed to allocate buffer memory.\n");
+        if(deviceHandler->allocateMemory(allocInfo, bufferMemory) != VK_SUCCESS) throw std::runtime_error("Failed to allocate buffer memory.\n");
         vkBindBufferMemory(deviceHandler->getLogicalDevice(), buffer, bufferMemory, 0);
     }
 
+    //device local memory that is also host visible (all of it on integrated GPUs and software rasterizers, the resizable BAR on discrete ones)
+    //can be written by the CPU and read by the GPU at full speed, so uploads into it need no staging buffer, copy or wait
+    //creates the buffer in such memory and maps it, or returns false (creating nothing) if there is none or its heap is out of budget
+    //the mapping is write combined on discrete GPUs: write it sequentially (memcpy) and don't read it back
+    bool CreateMappedDeviceLocalBuffer(VkDeviceSize size,
+                                       VkBufferUsageFlags usage,
+                                       VkBuffer& buffer,
+                                       VkDeviceMemory& bufferMemory,
+                                       void*& mapped,
+                                       DeviceHandler*& deviceHandler){
+        VkDevice& device = deviceHandler->getLogicalDevice();
+
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = usage;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VkBuffer candidate;
+        if(vkCreateBuffer(device, &bufferInfo, nullptr, &candidate) != VK_SUCCESS) throw std::runtime_error("Failed to create buffer.\n");
+
+        VkMemoryRequirements memRequirements;
+        vkGetBufferMemoryRequirements(device, candidate, &memRequirements);
+
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(deviceHandler->getPhysicalDevice(), &memProperties);
+
+        const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        for(uint32_t i = 0; i < memProperties.memoryTypeCount; ++i){
+            if(!(memRequirements.memoryTypeBits & (1 << i)) || (memProperties.memoryTypes[i].propertyFlags & properties) != properties) continue;
+            if(!deviceHandler->hasBudgetFor(memProperties.memoryTypes[i].heapIndex, memRequirements.size)) continue;
+
+            VkMemoryAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocInfo.allocationSize = memRequirements.size;
+            allocInfo.memoryTypeIndex = i;
+
+            VkDeviceMemory memory;
+            if(deviceHandler->allocateMemory(allocInfo, memory) != VK_SUCCESS) continue; //the budget is only an estimate
+
+            vkBindBufferMemory(device, candidate, memory, 0);
+            if(vkMapMemory(device, memory, 0, size, 0, &mapped) != VK_SUCCESS){
+                deviceHandler->freeMemory(memory);
+                break;
+            }
+
+            buffer = candidate;
+            bufferMemory = memory;
+            return true;
+        }
+
+        vkDestroyBuffer(device, candidate, nullptr);
+        return false;
+    }
+
     void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, CommandBuffersHandler*& buffersHandler) {
         VkCommandBuffer commandBuffer = buffersHandler->beginSingleTimeCommands();
 
@@ -0,0 +1,246 @@
+#pragma once
+
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+//vulkan.h is loaded above
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include "DeviceHandler.h"
+#include "BufferHelpers.h"
+#include "DeletionQueueHandler.h"
+#include "src/Globals.h"
+#include "src/RangeAllocator.h"
+#include "src/Vertex.h"
+
+//device local vertex / index buffers that chunk meshes are suballocated from, so an edited chunk only uploads its own mesh
+//and every chunk is drawn from the same two bindings, each with its own vertexOffset / firstIndex and 16 bit local indices
+//where device local memory can be mapped (and is in budget) meshes are written straight into it, otherwise uploads go
+//through a staging buffer per frame in flight and are copied by the frame's own command buffer
+//a mesh is never overwritten while a frame may still draw it: replaced meshes get a new range and the old one is
+//only freed through the deletion queue, so edits never wait on the GPU
+//meshes can also be written by GpuChunkMesher's compute shader, into ranges taken with Allocate
+class ChunkBuffers{
+    VkBuffer vertexBuffer;
+    VkDeviceMemory vertexBufferMemory;
+    void* vertexBufferMapped; //nullptr if it is uploaded to through staging
+    VkBuffer indexBuffer;
+    VkDeviceMemory indexBufferMemory;
+    void* indexBufferMapped;
+    RangeAllocator vertexRanges; //in vertices
+    RangeAllocator indexRanges; //in indices
+    bool writtenByDevice = false; //see setWrittenByDevice
+
+    //growing a staged buffer copies the old buffer's contents into the new one on the GPU, before this frame's uploads
+    struct Growth{
+        VkBuffer from;
+        VkBuffer to;
+        VkDeviceSize size;
+    };
+    std::vector<Growth> pendingGrowth;
+
+    VkBuffer stagingBuffers[MAX_FRAMES_IN_FLIGHT] = {};
+    VkDeviceMemory stagingBuffersMemory[MAX_FRAMES_IN_FLIGHT] = {};
+    void* stagingBuffersMapped[MAX_FRAMES_IN_FLIGHT] = {};
+    VkDeviceSize stagingCapacity[MAX_FRAMES_IN_FLIGHT] = {};
+    VkDeviceSize stagingUsed[MAX_FRAMES_IN_FLIGHT] = {};
+    std::vector<VkBufferCopy> vertexCopies[MAX_FRAMES_IN_FLIGHT];
+    std::vector<VkBufferCopy> indexCopies[MAX_FRAMES_IN_FLIGHT];
+
+    DeviceHandler* deviceHandler;
+    DeletionQueueHandler* deletionQueue;
+
+public:
+    ChunkBuffers(DeviceHandler* _dh, DeletionQueueHandler* _deletionQueue, uint32_t vertexCapacity = 1 << 20, uint32_t indexCapacity = 3 << 19)
+        : vertexRanges(vertexCapacity), indexRanges(indexCapacity), deviceHandler(_dh), deletionQueue(_deletionQueue){
+        createBuffer(sizeof(Vertex) * (VkDeviceSize)vertexCapacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBuffer, vertexBufferMemory, vertexBufferMapped, true);
+        createBuffer(sizeof(VertexIndex) * (VkDeviceSize)indexCapacity, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBuffer, indexBufferMemory, indexBufferMapped, true);
+    }
+
+    //the device must be idle and the deletion queue flushed (it may still hold frees into this)
+    ~ChunkBuffers(){
+        VkDevice& device = deviceHandler->getLogicalDevice();
+        vkDestroyBuffer(device, vertexBuffer, nullptr);
+        deviceHandler->freeMemory(vertexBufferMemory);
+        vkDestroyBuffer(device, indexBuffer, nullptr);
+        deviceHandler->freeMemory(indexBufferMemory);
+
+        for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i){
+            if(stagingBuffers[i] == VK_NULL_HANDLE) continue;
+            vkDestroyBuffer(device, stagingBuffers[i], nullptr);
+            deviceHandler->freeMemory(stagingBuffersMemory[i]); //unmapped implicitly
+        }
+    }
+
+    inline VkBuffer& getVertexBuffer(){ return vertexBuffer; }
+    inline VkBuffer& getIndexBuffer(){ return indexBuffer; }
+    inline uint32_t getUsedVertices(){ return vertexRanges.getUsed(); }
+    inline uint32_t getUsedIndices(){ return indexRanges.getUsed(); }
+    inline bool isWrittenDirectly(){ return vertexBufferMapped != nullptr && indexBufferMapped != nullptr; }
+    inline VkDeviceSize getVertexBufferSize(){ return sizeof(Vertex) * (VkDeviceSize)vertexRanges.getCapacity(); }
+    inline VkDeviceSize getIndexBufferSize(){ return sizeof(VertexIndex) * (VkDeviceSize)indexRanges.getCapacity(); }
+
+    //call before the GPU first writes a mesh, from then on a grown buffer is always filled by a GPU copy: copying a
+    //mapped one on the host would miss what frames still in flight write into it
+    inline void setWrittenByDevice(){ writtenByDevice = true; }
+
+    //call before a frame's Uploads, after its fence has signaled, with the total bytes of the vertices / indices they will upload
+    //reserves staging for the buffers that need it up front, so it doesn't grow in between uploads
+    void BeginUploads(uint32_t currentFrame, VkDeviceSize vertexBytes, VkDeviceSize indexBytes){
+        reserveStaging(currentFrame, (vertexBufferMapped != nullptr ? 0 : vertexBytes) + (indexBufferMapped != nullptr ? 0 : indexBytes));
+    }
+
+    //ranges for a mesh that the GPU writes, firstIndex is even when indexCount is a multiple of 6 (every mesh's is)
+    void Allocate(uint32_t vertexCount, uint32_t indexCount, uint32_t& vertexOffset, uint32_t& firstIndex){
+        vertexOffset = allocate(vertexRanges, vertexCount, true);
+        firstIndex = allocate(indexRanges, indexCount, false);
+    }
+
+    //allocates the mesh's ranges and writes it into them, or stages it for RecordCopies
+    //writing directly is safe right away: the ranges were free, so no frame in flight draws from them
+    void Upload(uint32_t currentFrame, const Vertex* vertices, uint32_t vertexCount, const VertexIndex* indices, uint32_t indexCount, uint32_t& vertexOffset, uint32_t& firstIndex){
+        Allocate(vertexCount, indexCount, vertexOffset, firstIndex);
+
+        write(currentFrame, vertexBufferMapped, vertices, sizeof(Vertex) * (VkDeviceSize)vertexCount, sizeof(Vertex) * (VkDeviceSize)vertexOffset, vertexCopies[currentFrame]);
+        write(currentFrame, indexBufferMapped, indices, sizeof(VertexIndex) * (VkDeviceSize)indexCount, sizeof(VertexIndex) * (VkDeviceSize)firstIndex, indexCopies[currentFrame]);
+    }
+
+    //frames already submitted may still draw the mesh, so its ranges are only reused once they have finished
+    void Free(uint32_t vertexOffset, uint32_t vertexCount, uint32_t firstIndex, uint32_t indexCount){
+        if(vertexCount == 0 && indexCount == 0) return;
+
+        deletionQueue->Defer([this, vertexOffset, vertexCount, firstIndex, indexCount](){
+            vertexRanges.Free(vertexOffset, vertexCount);
+            indexRanges.Free(firstIndex, indexCount);
+        });
+    }
+
+    //outside of a render pass, before anything that draws the chunks
+    //directly written meshes need nothing here, host writes are visible to everything submitted after them
+    void RecordCopies(VkCommandBuffer commandBuffer, uint32_t currentFrame){
+        if(pendingGrowth.empty() && vertexCopies[currentFrame].empty() && indexCopies[currentFrame].empty()) return;
+
+        //the old buffer's last writes (uploads or GpuChunkMesher's fills, possibly from a frame still in flight) must land before it's copied out
+        if(!pendingGrowth.empty())
+            transferBarrier(commandBuffer, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+        for(Growth& growth : pendingGrowth){
+            VkBufferCopy region{};
+            region.size = growth.size;
+            vkCmdCopyBuffer(commandBuffer, growth.from, growth.to, 1, &region);
+
+            //the uploads below may land in the grown part, or overwrite what was copied, so they have to come after
+            transferBarrier(commandBuffer, VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+        }
+        pendingGrowth.clear();
+
+        if(!vertexCopies[currentFrame].empty()) vkCmdCopyBuffer(commandBuffer, stagingBuffers[currentFrame], vertexBuffer, (uint32_t)vertexCopies[currentFrame].size(), vertexCopies[currentFrame].data());
+        if(!indexCopies[currentFrame].empty()) vkCmdCopyBuffer(commandBuffer, stagingBuffers[currentFrame], indexBuffer, (uint32_t)indexCopies[currentFrame].size(), indexCopies[currentFrame].data());
+
+        transferBarrier(commandBuffer, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+
+        vertexCopies[currentFrame].clear();
+        indexCopies[currentFrame].clear();
+        stagingUsed[currentFrame] = 0;
+    }
+
+private:
+    //mapped device local memory if there is some in budget (and it's wanted), otherwise device local memory that is uploaded to through staging
+    //storage buffers too, for GpuChunkMesher
+    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory, void*& mapped, bool tryMapped){
+        usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        mapped = nullptr;
+
+        if(tryMapped && BufferHelpers::CreateMappedDeviceLocalBuffer(size, usage, buffer, memory, mapped, deviceHandler)) return;
+        BufferHelpers::CreateBuffer(size, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, memory, deviceHandler);
+    }
+
+    uint32_t allocate(RangeAllocator& ranges, uint32_t count, bool vertices){
+        uint32_t offset = ranges.Allocate(count);
+        if(offset != RangeAllocator::INVALID) return offset;
+
+        grow(ranges, std::max(ranges.getCapacity() * 2, ranges.getCapacity() + count), vertices);
+        return ranges.Allocate(count);
+    }
+
+    void grow(RangeAllocator& ranges, uint32_t newCapacity, bool vertices){
+        VkBuffer& buffer = vertices ? vertexBuffer : indexBuffer;
+        VkDeviceMemory& memory = vertices ? vertexBufferMemory : indexBufferMemory;
+        void*& mapped = vertices ? vertexBufferMapped : indexBufferMapped;
+        VkDeviceSize elementSize = vertices ? sizeof(Vertex) : sizeof(VertexIndex);
+
+        VkBuffer oldBuffer = buffer;
+        VkDeviceMemory oldMemory = memory;
+        void* oldMapped = mapped;
+
+        //a staged buffer stays staged: direct writes into the new one could be overwritten by the GPU copy of the old contents
+        createBuffer(elementSize * newCapacity, vertices ? VK_BUFFER_USAGE_VERTEX_BUFFER_BIT : VK_BUFFER_USAGE_INDEX_BUFFER_BIT, buffer, memory, mapped, oldMapped != nullptr && !writtenByDevice);
+
+        //reading the old mapping back is slow where it's write combined, but growing is rare
+        if(oldMapped != nullptr && mapped != nullptr) memcpy(mapped, oldMapped, elementSize * ranges.getCapacity());
+        else pendingGrowth.push_back({ oldBuffer, buffer, elementSize * ranges.getCapacity() });
+        ranges.Grow(newCapacity);
+
+        //submitted frames draw from the old buffer, and the frame being prepared may copy out of it
+        DeviceHandler* dh = deviceHandler;
+        deletionQueue->DeferPastNextFrame([dh, oldBuffer, oldMemory](){
+            vkDestroyBuffer(dh->getLogicalDevice(), oldBuffer, nullptr);
+            dh->freeMemory(oldMemory);
+        });
+    }
+
+    //uploads that weren't recorded yet (the frame was skipped, e.g. the swapchain was out of date) are kept
+    void reserveStaging(uint32_t currentFrame, VkDeviceSize bytes){
+        VkDeviceSize required = stagingUsed[currentFrame] + bytes;
+        if(required <= stagingCapacity[currentFrame]) return;
+
+        VkBuffer oldBuffer = stagingBuffers[currentFrame];
+        VkDeviceMemory oldMemory = stagingBuffersMemory[currentFrame];
+        void* oldMapped = stagingBuffersMapped[currentFrame];
+
+        VkDevice& device = deviceHandler->getLogicalDevice();
+        stagingCapacity[currentFrame] = std::max(required, stagingCapacity[currentFrame] * 2);
+        BufferHelpers::CreateBuffer(stagingCapacity[currentFrame], VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffers[currentFrame], stagingBuffersMemory[currentFrame], deviceHandler);
+        vkMapMemory(device, stagingBuffersMemory[currentFrame], 0, stagingCapacity[currentFrame], 0, &stagingBuffersMapped[currentFrame]);
+
+        //nothing has been copied out of this frame's staging buffer since its fence, it can be replaced right away
+        if(oldBuffer != VK_NULL_HANDLE){
+            memcpy(stagingBuffersMapped[currentFrame], oldMapped, stagingUsed[currentFrame]);
+            vkDestroyBuffer(device, oldBuffer, nullptr);
+            deviceHandler->freeMemory(oldMemory);
+        }
+    }
+
+    void write(uint32_t currentFrame, void* mapped, const void* data, VkDeviceSize size, VkDeviceSize dstOffset, std::vector<VkBufferCopy>& copies){
+        if(size == 0) return;
+
+        if(mapped != nullptr){
+            memcpy((char*)mapped + dstOffset, data, size);
+            return;
+        }
+
+        //BeginUploads reserved enough, unless the buffer stopped being written directly when it grew
+        reserveStaging(currentFrame, size);
+        memcpy((char*)stagingBuffersMapped[currentFrame] + stagingUsed[currentFrame], data, size);
+
+        VkBufferCopy region{};
+        region.srcOffset = stagingUsed[currentFrame];
+        region.dstOffset = dstOffset;
+        region.size = size;
+        copies.push_back(region);
+
+        stagingUsed[currentFrame] += size;
+    }
+
+    void transferBarrier(VkCommandBuffer commandBuffer, VkAccessFlags dstAccess, VkPipelineStageFlags dstStage,
+        VkAccessFlags srcAccess = VK_ACCESS_TRANSFER_WRITE_BIT, VkPipelineStageFlags srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT){
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+};
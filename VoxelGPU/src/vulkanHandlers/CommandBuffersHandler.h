@@ -13,19 +13,40 @@ class CommandBuffersHandler{
 	VkCommandPool commandPool;
 	std::vector<VkCommandBuffer> commandBuffers;
 
+    //command pools can only be used by one thread at a time, so every recording thread gets its own pool per frame in flight
+    //index with [frame * threadCount + thread], each pool holds that thread's secondary command buffer for the frame
+    //the secondaries are kept across frames and only rerecorded (after ResetThreadCommandPools) when what they draw changes
+    uint32_t threadCount;
+    std::vector<VkCommandPool> threadCommandPools;
+    std::vector<VkCommandBuffer> threadCommandBuffers;
+
+    std::vector<VkCommandBuffer> overlayCommandBuffers; //secondary, one per frame, recorded on the main thread from commandPool
+
     DeviceHandler* deviceHandler;
 public:
-    CommandBuffersHandler(DeviceHandler*& _dh) : deviceHandler(_dh){
+    CommandBuffersHandler(DeviceHandler*& _dh, uint32_t _threadCount = 1) : threadCount(_threadCount), deviceHandler(_dh){
         createCommandPool();
         createCommandBuffers();
+        createThreadCommandBuffers();
     }
 
     ~CommandBuffersHandler(){
+        for(VkCommandPool pool : threadCommandPools) vkDestroyCommandPool(deviceHandler->getLogicalDevice(), pool, nullptr);
         vkDestroyCommandPool(deviceHandler->getLogicalDevice(), commandPool, nullptr); //command buffers automatically cleaned here too
     }
 
     inline std::vector<VkCommandBuffer>& GetCommandBuffers(){ return commandBuffers; }
     inline VkCommandPool& GetCommandPool(){ return commandPool; }
+    inline uint32_t GetThreadCount(){ return threadCount; }
+    inline VkCommandBuffer& GetThreadCommandBuffer(uint32_t frame, uint32_t thread){ return threadCommandBuffers[frame * threadCount + thread]; }
+    inline VkCommandBuffer& GetOverlayCommandBuffer(uint32_t frame){ return overlayCommandBuffers[frame]; }
+
+    //resetting the whole pool is cheaper than resetting its buffers one by one, only call once the frame's fence has signaled
+    void ResetThreadCommandPools(uint32_t frame){
+        for(uint32_t thread = 0; thread < threadCount; ++thread){
+            vkResetCommandPool(deviceHandler->getLogicalDevice(), threadCommandPools[frame * threadCount + thread], 0);
+        }
+    }
 
     VkCommandBuffer beginSingleTimeCommands() {
         VkCommandBufferAllocateInfo allocInfo{};
@@ -82,5 +103,33 @@ private:
 		allocInfo.commandBufferCount = (uint32_t) commandBuffers.size();
 
 		if(vkAllocateCommandBuffers(deviceHandler->getLogicalDevice(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) throw std::runtime_error("Could not allocate command buffers.\n");
+
+		overlayCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocInfo.commandBufferCount = (uint32_t) overlayCommandBuffers.size();
+
+		if(vkAllocateCommandBuffers(deviceHandler->getLogicalDevice(), &allocInfo, overlayCommandBuffers.data()) != VK_SUCCESS) throw std::runtime_error("Could not allocate overlay command buffers.\n");
 	}
+
+    void createThreadCommandBuffers(){
+        threadCommandPools.resize(MAX_FRAMES_IN_FLIGHT * threadCount);
+        threadCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT * threadCount);
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = 0; //buffers are reused across frames, and reset as a whole pool
+        poolInfo.queueFamilyIndex = deviceHandler->getQueueFamilyIndices().graphicsFamily.value();
+
+        for(size_t i = 0; i < threadCommandPools.size(); ++i){
+            if(vkCreateCommandPool(deviceHandler->getLogicalDevice(), &poolInfo, nullptr, &threadCommandPools[i]) != VK_SUCCESS) throw std::runtime_error("Failed to create thread command pool.\n");
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = threadCommandPools[i];
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandBufferCount = 1;
+
+            if(vkAllocateCommandBuffers(deviceHandler->getLogicalDevice(), &allocInfo, &threadCommandBuffers[i]) != VK_SUCCESS) throw std::runtime_error("Could not allocate thread command buffers.\n");
+        }
+    }
 };
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <utility>
+#include <stdint.h>
+
+//destroys resources once the GPU is done with them instead of waiting for the device to go idle
+//the renderer numbers every submitted frame, a deferred destroy runs once every frame submitted before it was deferred has finished
+class DeletionQueueHandler{
+    std::deque<std::pair<uint64_t, std::function<void()>>> pending; //last frame that may use the resource, how to destroy it
+    uint64_t submittedFrames = 0;
+
+public:
+    //everything still pending is destroyed, so the device must be idle by now
+    ~DeletionQueueHandler(){
+        Flush();
+    }
+
+    //call once per vkQueueSubmit, returns the submitted frame's number
+    inline uint64_t FrameSubmitted(){ return ++submittedFrames; }
+    inline uint64_t getSubmittedFrames(){ return submittedFrames; }
+
+    void Defer(std::function<void()> destroy){
+        pending.emplace_back(submittedFrames, std::move(destroy));
+    }
+
+    //for resources the frame that is being recorded still uses, not just the ones already submitted
+    void DeferPastNextFrame(std::function<void()> destroy){
+        pending.emplace_back(submittedFrames + 1, std::move(destroy));
+    }
+
+    //call after a frame's fence has signaled, with that frame's number (frames finish in submission order)
+    void Collect(uint64_t completedFrame){
+        while(!pending.empty() && pending.front().first <= completedFrame){
+            pending.front().second();
+            pending.pop_front();
+        }
+    }
+
+    inline void Flush(){ Collect(UINT64_MAX); }
+};
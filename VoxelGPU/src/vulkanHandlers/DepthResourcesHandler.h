@@ -9,33 +9,68 @@
 #include "ImageHelpers.h"
 #include "SwapchainHandler.h"
 
+class OffscreenTargetHandler; //forward decl, friend below
+
 class DepthResourcesHandler{
     friend SwapchainHandler;
+    friend OffscreenTargetHandler;
     
     VkImage depthImage;
-    VkDeviceMemory depthImageMemory;
+    VkDeviceMemory depthImageMemory; //VK_NULL_HANDLE once handed over to a newer DepthResourcesHandler
     VkImageView depthImageView;
 
+    //kept to tell if a later (smaller) depth image fits in this memory
+    VkDeviceSize depthMemorySize;
+    uint32_t depthMemoryTypeIndex;
+
     DeviceHandler* deviceHandler;
 
 public:
-    DepthResourcesHandler(DeviceHandler*& _dh, VkExtent2D swapchainExtent) : deviceHandler(_dh){
-        createDepthResources(swapchainExtent);
+    //previous is the depth resources being replaced (swapchain recreation), if the new image fits in its memory that memory
+    //is taken over rather than allocating again. previous keeps its image and view, so it can still be destroyed later
+    DepthResourcesHandler(DeviceHandler*& _dh, VkExtent2D swapchainExtent, DepthResourcesHandler* previous = nullptr) : deviceHandler(_dh){
+        createDepthResources(swapchainExtent, previous);
     }
 
     ~DepthResourcesHandler(){
         vkDestroyImageView(deviceHandler->getLogicalDevice(), depthImageView, nullptr);
         vkDestroyImage(deviceHandler->getLogicalDevice(), depthImage, nullptr);
-        vkFreeMemory(deviceHandler->getLogicalDevice(), depthImageMemory, nullptr);
+        if(depthImageMemory != VK_NULL_HANDLE) deviceHandler->freeMemory(depthImageMemory);
     }
 
     inline VkImageView& getDepthImageView() {return depthImageView; }
 
 protected:
-    void createDepthResources(VkExtent2D swapchainExtent) {
+    void createDepthResources(VkExtent2D swapchainExtent, DepthResourcesHandler* previous) {
         VkFormat depthFormat = findDepthFormat();
+        VkDevice& device = deviceHandler->getLogicalDevice();
+
+        depthImage = ImageHelpers::CreateImageWithoutMemory(swapchainExtent.width, swapchainExtent.height, 1, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, deviceHandler);
+
+        VkMemoryRequirements memReq;
+        vkGetImageMemoryRequirements(device, depthImage, &memReq);
+
+        //aliasing the previous image's memory while its last frames are in flight is fine: both are only written inside the
+        //render pass, whose external dependency already orders depth writes between frames on the queue
+        if(previous != nullptr && previous->depthImageMemory != VK_NULL_HANDLE && memReq.size <= previous->depthMemorySize && (memReq.memoryTypeBits & (1u << previous->depthMemoryTypeIndex))){
+            depthImageMemory = previous->depthImageMemory;
+            depthMemorySize = previous->depthMemorySize;
+            depthMemoryTypeIndex = previous->depthMemoryTypeIndex;
+            previous->depthImageMemory = VK_NULL_HANDLE;
+        }
+        else{
+            VkMemoryAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocInfo.allocationSize = memReq.size;
+            allocInfo.memoryTypeIndex = BufferHelpers::FindMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, deviceHandler);
+
+            if(deviceHandler->allocateMemory(allocInfo, depthImageMemory) != VK_SUCCESS) throw std::runtime_error("Failed to allocate depth image memory!\n");
+            depthMemorySize = memReq.size;
+            depthMemoryTypeIndex = allocInfo.memoryTypeIndex;
+        }
+
+        vkBindImageMemory(device, depthImage, depthImageMemory, 0);
 
-        ImageHelpers::CreateImage(swapchainExtent.width, swapchainExtent.height, 1, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory, deviceHandler);
         depthImageView = ImageHelpers::CreateImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1, deviceHandler->getLogicalDevice());
     }    
 
@@ -6,6 +6,7 @@
 //vulkan.h is loaded above
 
 #include "UniformBuffers.h"
+#include "ObjectBuffers.h"
 #include "TextureHandler.h"
 
 class DescriptorSetsHandler {
@@ -15,10 +16,11 @@ class DescriptorSetsHandler {
 
     VkDevice& logicalDevice;
     UniformBuffers* uniformBuffers;
+    ObjectBuffers* objectBuffers;
 
 public:
 
-    DescriptorSetsHandler(VkDevice& _ld, UniformBuffers* _ub, TextureHandler*& _th) : logicalDevice(_ld), uniformBuffers(_ub){
+    DescriptorSetsHandler(VkDevice& _ld, UniformBuffers* _ub, ObjectBuffers* _ob, TextureHandler*& _th) : logicalDevice(_ld), uniformBuffers(_ub), objectBuffers(_ob){
         createDescriptorSetLayout();
         createDescriptorPool();
         createDescriptorSets(_th);
@@ -33,6 +35,27 @@ public:
     inline std::vector<VkDescriptorSet> getDescriptorSets() { return descriptorSets; }
     inline VkDescriptorPool& getDescriptorPool() { return descriptorPool;  }
 
+    //after ObjectBuffers::Resize, none of the sets may be in use
+    void UpdateObjectBuffers(){
+        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            VkDescriptorBufferInfo objectBufferInfo{};
+            objectBufferInfo.buffer = objectBuffers->getBuffers()[i];
+            objectBufferInfo.offset = 0;
+            objectBufferInfo.range = objectBuffers->getBufferSize();
+
+            VkWriteDescriptorSet descriptorWrite{};
+            descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrite.dstSet = descriptorSets[i];
+            descriptorWrite.dstBinding = 2;
+            descriptorWrite.dstArrayElement = 0;
+            descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrite.descriptorCount = 1;
+            descriptorWrite.pBufferInfo = &objectBufferInfo;
+
+            vkUpdateDescriptorSets(logicalDevice, 1, &descriptorWrite, 0, nullptr);
+        }
+    }
+
 private:
     void createDescriptorSetLayout(){
         VkDescriptorSetLayoutBinding uboLayoutBinding{};
@@ -49,7 +72,14 @@ private:
         samplerLayoutBinding.pImmutableSamplers = nullptr;
         samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
-		std::array<VkDescriptorSetLayoutBinding, 2> bindings = {uboLayoutBinding, samplerLayoutBinding};
+        VkDescriptorSetLayoutBinding objectLayoutBinding{};
+        objectLayoutBinding.binding = 2;
+        objectLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        objectLayoutBinding.descriptorCount = 1;
+        objectLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        objectLayoutBinding.pImmutableSamplers = nullptr;
+
+		std::array<VkDescriptorSetLayoutBinding, 3> bindings = {uboLayoutBinding, samplerLayoutBinding, objectLayoutBinding};
 
         VkDescriptorSetLayoutCreateInfo layoutInfo{};
         layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -60,7 +90,7 @@ private:
     }
 
     void createDescriptorPool(){
-        std::array<VkDescriptorPoolSize, 2> poolSizes{};
+        std::array<VkDescriptorPoolSize, 3> poolSizes{};
         poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         poolSizes[0].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
         poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -69,6 +99,8 @@ private:
 #else
         poolSizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
 #endif
+        poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSizes[2].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
         VkDescriptorPoolCreateInfo poolInfo{};
         poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
         poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
@@ -126,5 +158,7 @@ private:
 
             vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
         }
+
+        UpdateObjectBuffers();
 	}
 };
\ No newline at end of file
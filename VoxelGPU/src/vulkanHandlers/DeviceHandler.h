@@ -1,6 +1,7 @@
 #pragma once
 
 #include <set>
+#include <unordered_map>
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
@@ -16,14 +17,24 @@ class DeviceHandler{
 	VkDevice logicalDevice;
 
     QueueFamilyIndices* queueFamilyIndices;
-    SwapchainSupportDetails* swapchainSupport;
+    SwapchainSupportDetails* swapchainSupport = nullptr; //stays nullptr when headless
 
     VkQueue graphicsQueue;
 	VkQueue presentQueue;
 
-    const std::vector<const char*> deviceExtensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME
-    };
+    std::vector<const char*> deviceExtensions; //the swapchain extension is only required when there is a surface
+
+    //every allocation goes through allocateMemory/freeMemory so the renderer's memory footprint can be reported
+    std::unordered_map<VkDeviceMemory, std::pair<VkDeviceSize, uint32_t>> allocations; //memory -> size, heap index
+    VkDeviceSize heapUsage[VK_MAX_MEMORY_HEAPS] = {};
+    VkDeviceSize allocatedBytes = 0;
+    VkDeviceSize peakAllocatedBytes = 0;
+
+    //VK_EXT_memory_budget, the driver's view of every heap (including other processes' use), optional
+    PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr;
+
+    bool multiDrawIndirect = false; //optional feature, see IndirectDrawBuffers
+    uint32_t maxDrawIndirectCount = 1;
 
 public:
     inline VkPhysicalDevice& getPhysicalDevice() { return physicalDevice; }
@@ -40,8 +51,17 @@ public:
         return getSwapchainSupportDetails();
     }
 
+    //surfaceHandler may be nullptr for headless rendering, then any device with a graphics queue will do (including software ones like lavapipe)
     DeviceHandler(InstanceHandler* instanceHandler, SurfaceHandler* surfaceHandler, const std::vector<const char*>& validationLayers){
+        if(surfaceHandler != nullptr) deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
         pickPhysicalDevice(instanceHandler, surfaceHandler);
+
+        if(instanceHandler->hasProperties2() && isExtensionSupported(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)){
+            deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            getMemoryProperties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(instanceHandler->getInstance(), "vkGetPhysicalDeviceMemoryProperties2KHR");
+        }
+
         createLogicalDevice(validationLayers);
     }
 
@@ -51,6 +71,80 @@ public:
         delete swapchainSupport;
     }
 
+    inline bool isHeadless() { return !queueFamilyIndices->requiresPresent; }
+    inline bool hasMultiDrawIndirect() { return multiDrawIndirect; }
+    inline uint32_t getMaxDrawIndirectCount() { return maxDrawIndirectCount; }
+
+    VkResult allocateMemory(const VkMemoryAllocateInfo& allocInfo, VkDeviceMemory& memory){
+        VkResult result = vkAllocateMemory(logicalDevice, &allocInfo, nullptr, &memory);
+        if(result != VK_SUCCESS) return result;
+
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+        uint32_t heap = memProperties.memoryTypes[allocInfo.memoryTypeIndex].heapIndex;
+
+        allocations[memory] = { allocInfo.allocationSize, heap };
+        heapUsage[heap] += allocInfo.allocationSize;
+        allocatedBytes += allocInfo.allocationSize;
+        if(allocatedBytes > peakAllocatedBytes) peakAllocatedBytes = allocatedBytes;
+
+        return result;
+    }
+
+    void freeMemory(VkDeviceMemory memory){
+        auto it = allocations.find(memory);
+        if(it != allocations.end()){
+            heapUsage[it->second.second] -= it->second.first;
+            allocatedBytes -= it->second.first;
+            allocations.erase(it);
+        }
+
+        vkFreeMemory(logicalDevice, memory, nullptr);
+    }
+
+    inline VkDeviceSize getAllocatedBytes() { return allocatedBytes; }
+    inline VkDeviceSize getPeakAllocatedBytes() { return peakAllocatedBytes; }
+
+    //bytes allocated from heaps with VK_MEMORY_HEAP_DEVICE_LOCAL_BIT (VRAM on discrete GPUs)
+    VkDeviceSize getDeviceLocalBytes(){
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+        VkDeviceSize total = 0;
+        for(uint32_t i = 0; i < memProperties.memoryHeapCount; ++i){
+            if(memProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) total += heapUsage[i];
+        }
+        return total;
+    }
+
+    //whether size more bytes can be allocated from heap while leaving an eighth of its budget for the driver, the swapchain and everyone else
+    //the budget is the driver's (VK_EXT_memory_budget) when it has one, otherwise the heap's size minus what this device allocated
+    bool hasBudgetFor(uint32_t heap, VkDeviceSize size){
+        VkDeviceSize budget, usage;
+
+        if(getMemoryProperties2 != nullptr){
+            VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+            budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+            VkPhysicalDeviceMemoryProperties2KHR memProperties{};
+            memProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+            memProperties.pNext = &budgetProperties;
+            getMemoryProperties2(physicalDevice, &memProperties);
+
+            budget = budgetProperties.heapBudget[heap];
+            usage = budgetProperties.heapUsage[heap];
+        }
+        else{
+            VkPhysicalDeviceMemoryProperties memProperties;
+            vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+            budget = memProperties.memoryHeaps[heap].size;
+            usage = heapUsage[heap];
+        }
+
+        return usage + size <= budget - budget / 8;
+    }
+
 private:
     void pickPhysicalDevice(InstanceHandler* instanceHandler, SurfaceHandler* surfaceHandler){
         //just count
@@ -71,6 +165,10 @@ private:
 		}
 
 		if(physicalDevice == VK_NULL_HANDLE) throw std::runtime_error("Failed to find a suitable GPU\n");
+
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+		std::cout << "Using device: " << deviceProperties.deviceName << '\n';
     }
 
 	bool isDeviceSuitable(VkPhysicalDevice& device, SurfaceHandler* surfaceHandler){
@@ -86,6 +184,14 @@ private:
 
         if(!allExtensionsSupported) return false;
 
+		if(surfaceHandler == nullptr){
+			if(indices.isComplete() && deviceFeatures.samplerAnisotropy){
+				queueFamilyIndices = new QueueFamilyIndices(indices);
+				return true;
+			}
+			return false;
+		}
+
 		bool swapchainAdequate = false;
 		SwapchainSupportDetails support(device, surfaceHandler);
 		swapchainAdequate = !support.formats.empty() && !support.presentModes.empty();
@@ -98,6 +204,19 @@ private:
         else return false;
 	}
 
+	bool isExtensionSupported(VkPhysicalDevice device, const char* extension){
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+		for(const auto& e : availableExtensions){
+			if(strcmp(e.extensionName, extension) == 0) return true;
+		}
+		return false;
+	}
+
 	bool checkDeviceExtensionSupport(VkPhysicalDevice device){
 		uint32_t extensionCount;
 
@@ -116,10 +235,8 @@ private:
     void createLogicalDevice(const std::vector<const char*>& validationLayers){
         //queues to be created
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos{};
-		std::set<uint32_t> uniqueQueueFamilies = {
-			queueFamilyIndices->graphicsFamily.value(),
-			queueFamilyIndices->presentFamily.value()
-		};
+		std::set<uint32_t> uniqueQueueFamilies = { queueFamilyIndices->graphicsFamily.value() };
+		if(queueFamilyIndices->presentFamily.has_value()) uniqueQueueFamilies.insert(queueFamilyIndices->presentFamily.value());
 
 		float queuePriority = 1.0f;
 		for(uint32_t queueFamily : uniqueQueueFamilies){
@@ -132,9 +249,19 @@ private:
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
 		//specifying what device features are needed
 		VkPhysicalDeviceFeatures deviceFeatures{};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC; //optional, for precompressed .vtex textures
+		deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect; //optional, a slice of the scene's draws in one command
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		multiDrawIndirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+		maxDrawIndirectCount = multiDrawIndirect ? properties.limits.maxDrawIndirectCount : 1;
 
 		//creating the logical device
 		VkDeviceCreateInfo createInfo{};
@@ -158,6 +285,7 @@ private:
 
 		//get a handle to the created queues
 		vkGetDeviceQueue(logicalDevice, queueFamilyIndices->graphicsFamily.value(), 0, &graphicsQueue);
-		vkGetDeviceQueue(logicalDevice, queueFamilyIndices->presentFamily.value(), 0, &presentQueue);
+		if(queueFamilyIndices->presentFamily.has_value()) vkGetDeviceQueue(logicalDevice, queueFamilyIndices->presentFamily.value(), 0, &presentQueue);
+		else presentQueue = graphicsQueue; //headless, never presented to
     }
 };
\ No newline at end of file
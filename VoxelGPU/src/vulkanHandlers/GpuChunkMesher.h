@@ -0,0 +1,416 @@
+#pragma once
+
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+//vulkan.h is loaded above
+
+#include <vector>
+#include <array>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+#include "DeviceHandler.h"
+#include "BufferHelpers.h"
+#include "DeletionQueueHandler.h"
+#include "ShaderHandler.h"
+#include "src/Globals.h"
+#include "src/Vertex.h"
+#include "src/ECS/Chunk.h"
+#include "src/ECS/ChunkMesher.h"
+
+//one chunk for the compute shader to mesh, laid out like Job in shaders/chunkmesh.comp (std430, every member is 4 bytes)
+struct GpuMeshJob{
+    int32_t origin[3]; //the chunk's first cell
+    uint32_t vertexOffset; //where its mesh goes in ChunkBuffers
+    uint32_t firstIndex; //even, the shader writes indices two to a word
+    uint32_t slots[27]; //of the chunks around it (see NeighbourhoodIndex), GpuChunkMesher::NO_SLOT where there is none
+    uint32_t rowOffsets[6 * CHUNK_SIZE * CHUNK_SIZE]; //see ChunkMesher::FaceLayout
+};
+
+//meshes chunks on the GPU with a compute shader (shaders/chunkmesh.comp) instead of ChunkMesher::MeshChunk, writing the
+//vertices and indices straight into ChunkBuffers, so only the cells are uploaded (8 bytes each) rather than the meshes
+//the GPU keeps a copy of every chunk's cells in a slot of one storage buffer, updated through a staging buffer per frame
+//whenever the chunk is remeshed (every change to a chunk's cells or light remeshes it), neighbours are read from their slots
+//the CPU still works out where each row of faces goes (ChunkMesher::FaceLayout, occupancy bits only), so the meshes are
+//the CPU mesher's word for word and the draw ranges are built from the same counts
+class GpuChunkMesher{
+public:
+    static const uint32_t NO_SLOT = UINT32_MAX;
+    static const uint32_t WORDS_PER_CELL = 2;
+    static const VkDeviceSize SLOT_SIZE = sizeof(uint32_t) * WORDS_PER_CELL * CHUNK_VOLUME;
+
+private:
+    //the shader writes vertices as 10 words
+    static_assert(sizeof(Vertex) == 10 * sizeof(uint32_t), "chunkmesh.comp writes Vertex as 10 words");
+    static_assert(sizeof(GpuMeshJob) == (32 + 6 * CHUNK_SIZE * CHUNK_SIZE) * sizeof(uint32_t), "GpuMeshJob has to match the shader's Job");
+
+    //laid out like the shader's push constants
+    struct PushConstants{
+        uint32_t firstJob;
+        float voxelSize;
+        float colorScale;
+        float aoLevels[4];
+        float lightLevels[LightEngine::MAX_LIGHT + 1];
+    };
+
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSets[MAX_FRAMES_IN_FLIGHT];
+    VkBuffer boundBuffers[MAX_FRAMES_IN_FLIGHT][4] = {}; //what each frame's set points at, rewritten when one is replaced
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+
+    VkBuffer cellBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory cellBufferMemory = VK_NULL_HANDLE;
+    uint32_t slotCapacity = 0;
+    uint32_t maxSlots; //what one storage buffer descriptor can reach
+    VkDeviceSize maxStorageBufferRange;
+    uint32_t nextSlot = 0; //slots from here on were never used
+    std::vector<uint32_t> freeSlots;
+
+    //growing the cell buffer copies the old one's slots over on the GPU, before the frame's uploads
+    struct Growth{
+        VkBuffer from;
+        VkBuffer to;
+        VkDeviceSize size;
+    };
+    std::vector<Growth> pendingGrowth;
+
+    VkBuffer stagingBuffers[MAX_FRAMES_IN_FLIGHT] = {};
+    VkDeviceMemory stagingBuffersMemory[MAX_FRAMES_IN_FLIGHT] = {};
+    void* stagingBuffersMapped[MAX_FRAMES_IN_FLIGHT] = {};
+    uint32_t stagingCapacity[MAX_FRAMES_IN_FLIGHT] = {}; //in slots
+    std::vector<VkBufferCopy> cellCopies[MAX_FRAMES_IN_FLIGHT];
+
+    VkBuffer jobBuffers[MAX_FRAMES_IN_FLIGHT] = {};
+    VkDeviceMemory jobBuffersMemory[MAX_FRAMES_IN_FLIGHT] = {};
+    void* jobBuffersMapped[MAX_FRAMES_IN_FLIGHT] = {};
+    uint32_t jobCapacity[MAX_FRAMES_IN_FLIGHT] = {};
+    uint32_t jobCount[MAX_FRAMES_IN_FLIGHT] = {};
+    uint32_t maxJobsPerDispatch;
+
+    DeviceHandler* deviceHandler;
+    DeletionQueueHandler* deletionQueue;
+
+public:
+    //throws if the graphics queue can't run compute shaders or shaders/chunkmesh.spv can't be loaded
+    GpuChunkMesher(DeviceHandler* _dh, DeletionQueueHandler* _deletionQueue) : deviceHandler(_dh), deletionQueue(_deletionQueue){
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(deviceHandler->getPhysicalDevice(), &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(deviceHandler->getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+        if(!(queueFamilies[deviceHandler->getQueueFamilyIndices().graphicsFamily.value()].queueFlags & VK_QUEUE_COMPUTE_BIT)) throw std::runtime_error("The graphics queue doesn't support compute.\n");
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(deviceHandler->getPhysicalDevice(), &properties);
+        maxStorageBufferRange = properties.limits.maxStorageBufferRange;
+        maxSlots = (uint32_t)std::min<VkDeviceSize>(maxStorageBufferRange / SLOT_SIZE, NO_SLOT - 1);
+        maxJobsPerDispatch = properties.limits.maxComputeWorkGroupCount[1];
+
+        //the destructor doesn't run if this throws, so whatever was created so far is destroyed here
+        try{
+            createPipeline();
+            createDescriptorSets();
+            growCells(std::min(1024u, maxSlots));
+        }
+        catch(...){
+            destroy();
+            throw;
+        }
+    }
+
+    //the device must be idle and the deletion queue flushed (it may still hold frees into this)
+    ~GpuChunkMesher(){
+        destroy();
+    }
+
+    //the shader can only write buffers a storage buffer descriptor can cover
+    inline bool canReach(VkDeviceSize bufferSize){ return bufferSize <= maxStorageBufferRange; }
+    inline bool canAllocateSlots(uint32_t count){ return (uint32_t)freeSlots.size() + (maxSlots - nextSlot) >= count; }
+
+    //check canAllocateSlots first
+    uint32_t AllocateSlot(){
+        if(!freeSlots.empty()){
+            uint32_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+
+        if(nextSlot == slotCapacity) growCells(std::min(slotCapacity * 2, maxSlots));
+        return nextSlot++;
+    }
+
+    //the frame being prepared may still mesh a neighbour from it
+    void FreeSlot(uint32_t slot){
+        deletionQueue->DeferPastNextFrame([this, slot](){ freeSlots.push_back(slot); });
+    }
+
+    //call after the frame's fence has signaled, before its StageCells / AddJob calls
+    //what was staged for a frame that wasn't recorded (e.g. the swapchain was out of date) is kept
+    void Reserve(uint32_t currentFrame, uint32_t cellUploads, uint32_t jobs){
+        uint32_t stagedSlots = (uint32_t)cellCopies[currentFrame].size();
+        if(stagedSlots + cellUploads > stagingCapacity[currentFrame])
+            growHostBuffer(currentFrame, stagingBuffers, stagingBuffersMemory, stagingBuffersMapped, stagingCapacity, std::max(stagedSlots + cellUploads, stagingCapacity[currentFrame] * 2), SLOT_SIZE, stagedSlots, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+        if(jobCount[currentFrame] + jobs > jobCapacity[currentFrame])
+            growHostBuffer(currentFrame, jobBuffers, jobBuffersMemory, jobBuffersMapped, jobCapacity, std::max(jobCount[currentFrame] + jobs, std::max(jobCapacity[currentFrame] * 2, 64u)), sizeof(GpuMeshJob), jobCount[currentFrame], VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    }
+
+    //where to write the cells (see PackCells) that are copied into slot before the frame's meshing, valid until the next Reserve
+    //only the calls are serial, the returned slots can be written from any thread
+    uint32_t* StageCells(uint32_t currentFrame, uint32_t slot){
+        VkBufferCopy region{};
+        region.srcOffset = SLOT_SIZE * cellCopies[currentFrame].size();
+        region.dstOffset = SLOT_SIZE * slot;
+        region.size = SLOT_SIZE;
+        cellCopies[currentFrame].push_back(region);
+
+        return (uint32_t*)((char*)stagingBuffersMapped[currentFrame] + region.srcOffset);
+    }
+
+    //a job to fill in, valid until the next Reserve
+    GpuMeshJob* AddJob(uint32_t currentFrame){
+        return (GpuMeshJob*)jobBuffersMapped[currentFrame] + jobCount[currentFrame]++;
+    }
+
+    //WORDS_PER_CELL words: the color (see PackColor) with the cell's light (see Chunk::Light) in the top 8 bits, then the
+    //material with bit 16 set if it's solid
+    static inline void PackCell(const GridVoxel& voxel, uint8_t light, uint32_t* words){
+        words[0] = (voxel.Color & 0xFFFFFF) | ((uint32_t)light << 24);
+        words[1] = voxel.Material | ((uint32_t)voxel.Solid << 16);
+    }
+
+    //every cell in Chunk::Index order, see PackCell
+    static void PackCells(const Chunk& chunk, uint32_t* cells){
+        for(uint32_t i = 0; i < CHUNK_VOLUME; ++i) PackCell(chunk.Voxels[i], chunk.Light[i], cells + i * WORDS_PER_CELL);
+    }
+
+    //outside of a render pass, after ChunkBuffers::RecordCopies (which may grow the buffers the meshes go into) and
+    //before anything that draws the chunks
+    //writeCells, if given, records the GPU writing slots itself (e.g. GpuTerrainGenerator::RecordFills) into the cell buffer
+    //it's passed: after the buffer has grown and before the staged cells are copied in, so cells staged later still win
+    void RecordDispatch(VkCommandBuffer commandBuffer, uint32_t currentFrame, VkBuffer vertexBuffer, VkBuffer indexBuffer, const std::function<void(VkCommandBuffer, VkBuffer)>& writeCells = nullptr){
+        if(pendingGrowth.empty() && cellCopies[currentFrame].empty() && jobCount[currentFrame] == 0 && !writeCells) return;
+
+        //earlier frames' meshing may still be reading the slots that are about to be overwritten, and their writes (the last
+        //frame's cell copies and fills) have to land before the growth copies read the old buffers
+        barrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT);
+
+        for(Growth& growth : pendingGrowth){
+            VkBufferCopy region{};
+            region.size = growth.size;
+            vkCmdCopyBuffer(commandBuffer, growth.from, growth.to, 1, &region);
+            barrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT);
+        }
+        pendingGrowth.clear();
+
+        if(writeCells) writeCells(commandBuffer, cellBuffer);
+
+        if(!cellCopies[currentFrame].empty()) vkCmdCopyBuffer(commandBuffer, stagingBuffers[currentFrame], cellBuffer, (uint32_t)cellCopies[currentFrame].size(), cellCopies[currentFrame].data());
+        cellCopies[currentFrame].clear();
+
+        uint32_t jobs = jobCount[currentFrame];
+        jobCount[currentFrame] = 0;
+        if(jobs == 0) return;
+
+        //the cells just copied, and ChunkBuffers' copies into the buffers the meshes are written to
+        barrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+        updateDescriptorSet(currentFrame, vertexBuffer, indexBuffer);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSets[currentFrame], 0, nullptr);
+
+        //the same constants the CPU mesher multiplies with, so the results round the same way
+        PushConstants constants{};
+        constants.voxelSize = VOXEL_SIZE;
+        constants.colorScale = 1.0f / 255.0f; //see UnpackColor
+        std::copy(std::begin(ChunkMesher::AO_LEVELS), std::end(ChunkMesher::AO_LEVELS), constants.aoLevels);
+        std::copy(ChunkMesher::LIGHT_LEVELS.begin(), ChunkMesher::LIGHT_LEVELS.end(), constants.lightLevels);
+
+        //a workgroup per face direction and y of a chunk, a row of cells along x per invocation
+        for(uint32_t first = 0; first < jobs; first += maxJobsPerDispatch){
+            constants.firstJob = first;
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &constants);
+            vkCmdDispatch(commandBuffer, 6 * CHUNK_SIZE, std::min(maxJobsPerDispatch, jobs - first), 1);
+        }
+
+        //drawing the meshes, and later frames growing ChunkBuffers with a copy
+        barrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT);
+    }
+
+private:
+    void createPipeline(){
+        VkDevice& device = deviceHandler->getLogicalDevice();
+
+        //cells, jobs, vertices, indices
+        std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+        for(uint32_t i = 0; i < bindings.size(); ++i){
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        if(vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) throw std::runtime_error("Failed to create chunk meshing descriptor set layout.\n");
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(PushConstants);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if(vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) throw std::runtime_error("Failed to create chunk meshing pipeline layout.\n");
+
+        //only needed at pipeline creation time
+        ShaderHandler shaderHandler("shaders/chunkmesh.spv", device);
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shaderHandler.getComputeShaderModule();
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+
+        if(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) throw std::runtime_error("Failed to create chunk meshing pipeline.\n");
+    }
+
+    void createDescriptorSets(){
+        VkDevice& device = deviceHandler->getLogicalDevice();
+
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount = 4 * MAX_FRAMES_IN_FLIGHT;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
+
+        if(vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) throw std::runtime_error("Failed to create chunk meshing descriptor pool.\n");
+
+        std::array<VkDescriptorSetLayout, MAX_FRAMES_IN_FLIGHT> layouts;
+        layouts.fill(descriptorSetLayout);
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = MAX_FRAMES_IN_FLIGHT;
+        allocInfo.pSetLayouts = layouts.data();
+
+        if(vkAllocateDescriptorSets(device, &allocInfo, descriptorSets) != VK_SUCCESS) throw std::runtime_error("Failed to allocate chunk meshing descriptor sets.\n");
+    }
+
+    //the frame's fence has signaled, nothing uses its set
+    void updateDescriptorSet(uint32_t currentFrame, VkBuffer vertexBuffer, VkBuffer indexBuffer){
+        VkBuffer buffers[4] = { cellBuffer, jobBuffers[currentFrame], vertexBuffer, indexBuffer };
+        if(std::equal(buffers, buffers + 4, boundBuffers[currentFrame])) return;
+
+        std::array<VkDescriptorBufferInfo, 4> bufferInfos{};
+        std::array<VkWriteDescriptorSet, 4> descriptorWrites{};
+        for(uint32_t i = 0; i < 4; ++i){
+            bufferInfos[i].buffer = buffers[i];
+            bufferInfos[i].offset = 0;
+            bufferInfos[i].range = VK_WHOLE_SIZE;
+
+            descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[i].dstSet = descriptorSets[currentFrame];
+            descriptorWrites[i].dstBinding = i;
+            descriptorWrites[i].dstArrayElement = 0;
+            descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrites[i].descriptorCount = 1;
+            descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+
+            boundBuffers[currentFrame][i] = buffers[i];
+        }
+
+        vkUpdateDescriptorSets(deviceHandler->getLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+
+    void growCells(uint32_t newCapacity){
+        VkBuffer oldBuffer = cellBuffer;
+        VkDeviceMemory oldMemory = cellBufferMemory;
+
+        BufferHelpers::CreateBuffer(SLOT_SIZE * newCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, cellBuffer, cellBufferMemory, deviceHandler);
+
+        if(oldBuffer != VK_NULL_HANDLE){
+            pendingGrowth.push_back({ oldBuffer, cellBuffer, SLOT_SIZE * slotCapacity });
+
+            //submitted frames mesh from the old buffer, and the frame being prepared copies out of it
+            DeviceHandler* dh = deviceHandler;
+            deletionQueue->DeferPastNextFrame([dh, oldBuffer, oldMemory](){
+                vkDestroyBuffer(dh->getLogicalDevice(), oldBuffer, nullptr);
+                dh->freeMemory(oldMemory);
+            });
+        }
+        slotCapacity = newCapacity;
+    }
+
+    //a frame's host visible buffer, the GPU is done with it (its fence has signaled), the first keep elements are kept
+    void growHostBuffer(uint32_t currentFrame, VkBuffer* buffers, VkDeviceMemory* memories, void** mapped, uint32_t* capacity, uint32_t newCapacity, VkDeviceSize elementSize, uint32_t keep, VkBufferUsageFlags usage){
+        VkBuffer oldBuffer = buffers[currentFrame];
+        VkDeviceMemory oldMemory = memories[currentFrame];
+        void* oldMapped = mapped[currentFrame];
+
+        BufferHelpers::CreateBuffer(elementSize * newCapacity, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffers[currentFrame], memories[currentFrame], deviceHandler);
+        if(vkMapMemory(deviceHandler->getLogicalDevice(), memories[currentFrame], 0, elementSize * newCapacity, 0, &mapped[currentFrame]) != VK_SUCCESS){
+            //the old buffer stays in place, so the mesher is still consistent (and destroyable) after the throw
+            destroyHostBuffer(buffers[currentFrame], memories[currentFrame]);
+            buffers[currentFrame] = oldBuffer;
+            memories[currentFrame] = oldMemory;
+            mapped[currentFrame] = oldMapped;
+            throw std::runtime_error("Failed to map chunk meshing host buffer.\n");
+        }
+        capacity[currentFrame] = newCapacity;
+
+        if(oldBuffer != VK_NULL_HANDLE){
+            memcpy(mapped[currentFrame], oldMapped, elementSize * keep);
+            destroyHostBuffer(oldBuffer, oldMemory);
+        }
+    }
+
+    //handles that were never created are VK_NULL_HANDLE, which every destroy call ignores
+    void destroy(){
+        VkDevice& device = deviceHandler->getLogicalDevice();
+        vkDestroyPipeline(device, pipeline, nullptr);
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+
+        vkDestroyBuffer(device, cellBuffer, nullptr);
+        deviceHandler->freeMemory(cellBufferMemory);
+
+        for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i){
+            destroyHostBuffer(stagingBuffers[i], stagingBuffersMemory[i]);
+            destroyHostBuffer(jobBuffers[i], jobBuffersMemory[i]);
+        }
+    }
+
+    void destroyHostBuffer(VkBuffer buffer, VkDeviceMemory memory){
+        if(buffer == VK_NULL_HANDLE) return;
+        vkDestroyBuffer(deviceHandler->getLogicalDevice(), buffer, nullptr);
+        deviceHandler->freeMemory(memory); //unmapped implicitly
+    }
+
+    void barrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess){
+        VkMemoryBarrier memoryBarrier{};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = srcAccess;
+        memoryBarrier.dstAccessMask = dstAccess;
+        vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+};
@@ -0,0 +1,393 @@
+#pragma once
+
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+//vulkan.h is loaded above
+
+#include <vector>
+#include <array>
+#include <cstring>
+#include <algorithm>
+#include "DeviceHandler.h"
+#include "BufferHelpers.h"
+#include "CommandBuffersHandler.h"
+#include "ShaderHandler.h"
+#include "GpuChunkMesher.h"
+#include "src/Globals.h"
+#include "src/ECS/Chunk.h"
+#include "src/ECS/LightEngine.h"
+#include "src/ECS/TerrainGenerator.h"
+
+//a TerrainGenerator's settings for shaders/terrain.comp, laid out like its Terrain (std430, every member is 4 bytes)
+struct GpuTerrain{
+    uint32_t seed;
+    uint32_t octaves;
+    uint32_t warpOctaves;
+    int32_t soilDepth;
+    float frequency;
+    float lacunarity;
+    float persistence;
+    float warpFrequency;
+    float warpStrength;
+    float baseHeight;
+    float amplitude;
+    float scale; //see TerrainGenerator::FbmScale
+    float warpScale;
+    uint32_t cells[4][GpuChunkMesher::WORDS_PER_CELL]; //air, grass, dirt and stone packed like GpuChunkMesher::PackCell, lit like a generated chunk
+};
+
+//a chunk to fill, or a column of chunks to write the heights of, laid out like the shader's Job
+struct GpuTerrainJob{
+    int32_t origin[3]; //the first cell
+    uint32_t slot; //GpuChunkMesher's, NO_SLOT to write the heights instead
+    GpuTerrain terrain;
+};
+
+//generates TerrainGenerator's terrain on the GPU with a compute shader (shaders/terrain.comp), the same heights to the bit
+//ColumnHeights reads the heights back for the chunks' copy on the CPU (4 bytes per column rather than 8 per cell), and when
+//the chunks are meshed on the GPU RecordFills writes their cells straight into GpuChunkMesher's slots, so the cells
+//of a generated chunk are never uploaded. That's the case as long as the chunk is untouched, see CanFill
+class GpuTerrainGenerator{
+public:
+    static const uint32_t NO_TERRAIN = UINT32_MAX;
+
+private:
+    static_assert(sizeof(GpuTerrainJob) == 25 * sizeof(uint32_t), "GpuTerrainJob has to match the shader's Job");
+
+    //an invocation per column of cells
+    static const uint32_t COLUMNS_PER_GROUP = 64;
+    static const uint32_t GROUPS_PER_JOB = CHUNK_SIZE * CHUNK_SIZE / COLUMNS_PER_GROUP;
+
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSets[MAX_FRAMES_IN_FLIGHT + 1]; //a set per frame for the fills, the last for ColumnHeights
+    VkBuffer boundBuffers[MAX_FRAMES_IN_FLIGHT][2] = {};
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    uint32_t maxJobsPerDispatch;
+
+    VkBuffer jobBuffers[MAX_FRAMES_IN_FLIGHT] = {};
+    VkDeviceMemory jobBuffersMemory[MAX_FRAMES_IN_FLIGHT] = {};
+    void* jobBuffersMapped[MAX_FRAMES_IN_FLIGHT] = {};
+    uint32_t jobCapacity[MAX_FRAMES_IN_FLIGHT] = {};
+    uint32_t jobCount[MAX_FRAMES_IN_FLIGHT] = {};
+
+    std::vector<GpuTerrain> terrains; //see AddTerrain
+
+    DeviceHandler* deviceHandler;
+    CommandBuffersHandler* commandBuffersHandler;
+
+public:
+    //throws if the graphics queue can't run compute shaders or shaders/terrain.spv can't be loaded
+    GpuTerrainGenerator(DeviceHandler* _dh, CommandBuffersHandler* _cbh) : deviceHandler(_dh), commandBuffersHandler(_cbh){
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(deviceHandler->getPhysicalDevice(), &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(deviceHandler->getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+        if(!(queueFamilies[deviceHandler->getQueueFamilyIndices().graphicsFamily.value()].queueFlags & VK_QUEUE_COMPUTE_BIT)) throw std::runtime_error("The graphics queue doesn't support compute.\n");
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(deviceHandler->getPhysicalDevice(), &properties);
+        maxJobsPerDispatch = properties.limits.maxComputeWorkGroupCount[1];
+
+        //the destructor doesn't run if this throws, so whatever was created so far is destroyed here
+        try{
+            createPipeline();
+            createDescriptorSets();
+        }
+        catch(...){
+            destroy();
+            throw;
+        }
+    }
+
+    //the device must be idle
+    ~GpuTerrainGenerator(){
+        destroy();
+    }
+
+    //the index chunks generated by generator keep (see Chunk::GpuTerrain), the same settings always give the same index
+    uint32_t AddTerrain(const TerrainGenerator& generator){
+        const TerrainGenerator::Settings& settings = generator.getSettings();
+
+        GpuTerrain terrain{};
+        terrain.seed = settings.Seed;
+        terrain.octaves = settings.Octaves;
+        terrain.warpOctaves = settings.WarpOctaves;
+        terrain.soilDepth = settings.SoilDepth;
+        terrain.frequency = settings.Frequency;
+        terrain.lacunarity = settings.Lacunarity;
+        terrain.persistence = settings.Persistence;
+        terrain.warpFrequency = settings.WarpFrequency;
+        terrain.warpStrength = settings.WarpStrength;
+        terrain.baseHeight = settings.BaseHeight;
+        terrain.amplitude = settings.Amplitude;
+        terrain.scale = generator.FbmScale(settings.Octaves);
+        terrain.warpScale = generator.FbmScale(settings.WarpOctaves);
+
+        //how LightEngine::ChunksGenerated lights them, which CanFill checks is still the case
+        GpuChunkMesher::PackCell(GridVoxel(), LightEngine::OPEN_SKY, terrain.cells[0]);
+        GpuChunkMesher::PackCell(generator.getGrass(), generator.getGrass().Emission, terrain.cells[1]);
+        GpuChunkMesher::PackCell(generator.getDirt(), generator.getDirt().Emission, terrain.cells[2]);
+        GpuChunkMesher::PackCell(generator.getStone(), generator.getStone().Emission, terrain.cells[3]);
+
+        for(uint32_t i = 0; i < terrains.size(); ++i) if(memcmp(&terrains[i], &terrain, sizeof(GpuTerrain)) == 0) return i;
+        terrains.push_back(terrain);
+        return (uint32_t)terrains.size() - 1;
+    }
+
+    //TerrainGenerator::ColumnHeights of columnCount columns of chunks from minChunk, columnsX per row along x, into heights
+    //(CHUNK_SIZE * CHUNK_SIZE per column of chunks, laid out like ColumnHeights'). Waits for the GPU
+    void ColumnHeights(uint32_t terrain, const glm::ivec3& minChunk, uint32_t columnsX, uint32_t columnCount, int32_t* heights){
+        if(columnCount == 0) return;
+
+        VkBuffer jobBuffer, heightBuffer;
+        VkDeviceMemory jobBufferMemory, heightBufferMemory;
+        void* jobsMapped;
+        void* heightsMapped;
+        VkDeviceSize heightsSize = sizeof(int32_t) * CHUNK_SIZE * CHUNK_SIZE * (VkDeviceSize)columnCount;
+        createHostBuffer(sizeof(GpuTerrainJob) * (VkDeviceSize)columnCount, jobBuffer, jobBufferMemory, jobsMapped);
+        try{ createHostBuffer(heightsSize, heightBuffer, heightBufferMemory, heightsMapped); }
+        catch(...){
+            destroyHostBuffer(jobBuffer, jobBufferMemory);
+            throw;
+        }
+
+        GpuTerrainJob* jobs = (GpuTerrainJob*)jobsMapped;
+        for(uint32_t column = 0; column < columnCount; ++column){
+            jobs[column].origin[0] = (minChunk.x + (int32_t)(column % columnsX)) * CHUNK_SIZE;
+            jobs[column].origin[1] = 0;
+            jobs[column].origin[2] = (minChunk.z + (int32_t)(column / columnsX)) * CHUNK_SIZE;
+            jobs[column].slot = GpuChunkMesher::NO_SLOT;
+            jobs[column].terrain = terrains[terrain];
+        }
+
+        writeDescriptorSet(MAX_FRAMES_IN_FLIGHT, heightBuffer, jobBuffer);
+
+        VkCommandBuffer commandBuffer = commandBuffersHandler->beginSingleTimeCommands();
+        recordJobs(commandBuffer, MAX_FRAMES_IN_FLIGHT, columnCount);
+        barrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+        commandBuffersHandler->endSingleTimeCommands(commandBuffer);
+
+        memcpy(heights, heightsMapped, heightsSize);
+
+        destroyHostBuffer(jobBuffer, jobBufferMemory);
+        destroyHostBuffer(heightBuffer, heightBufferMemory);
+    }
+
+    //whether the chunk's cells are still the ones RecordFills would write: its voxels haven't been edited since it was generated
+    //(see Chunk::GpuTerrain) and it's lit the way generated chunks start out, which light spreading in from neighbours that
+    //aren't plain terrain changes
+    static bool CanFill(const Chunk& chunk){
+        if(chunk.GpuTerrain == NO_TERRAIN) return false;
+
+        for(uint32_t i = 0; i < CHUNK_VOLUME; ++i){
+            const GridVoxel& voxel = chunk.Voxels[i];
+            if(chunk.Light[i] != (voxel.Solid ? voxel.Emission : LightEngine::OPEN_SKY)) return false;
+        }
+        return true;
+    }
+
+    //call after the frame's fence has signaled, before its AddFill calls
+    //what was added for a frame that wasn't recorded (e.g. the swapchain was out of date) is kept
+    void Reserve(uint32_t currentFrame, uint32_t fills){
+        if(jobCount[currentFrame] + fills <= jobCapacity[currentFrame]) return;
+
+        VkBuffer oldBuffer = jobBuffers[currentFrame];
+        VkDeviceMemory oldMemory = jobBuffersMemory[currentFrame];
+        void* oldMapped = jobBuffersMapped[currentFrame];
+
+        uint32_t newCapacity = std::max(jobCount[currentFrame] + fills, std::max(jobCapacity[currentFrame] * 2, 64u));
+        createHostBuffer(sizeof(GpuTerrainJob) * (VkDeviceSize)newCapacity, jobBuffers[currentFrame], jobBuffersMemory[currentFrame], jobBuffersMapped[currentFrame]);
+        jobCapacity[currentFrame] = newCapacity;
+
+        if(oldBuffer != VK_NULL_HANDLE){
+            memcpy(jobBuffersMapped[currentFrame], oldMapped, sizeof(GpuTerrainJob) * jobCount[currentFrame]);
+            destroyHostBuffer(oldBuffer, oldMemory);
+        }
+    }
+
+    //fills the chunk's GpuSlot before the frame's meshing, check CanFill first
+    void AddFill(uint32_t currentFrame, const Chunk& chunk){
+        GpuTerrainJob& job = ((GpuTerrainJob*)jobBuffersMapped[currentFrame])[jobCount[currentFrame]++];
+        glm::ivec3 origin = chunk.Position * CHUNK_SIZE;
+        job.origin[0] = origin.x;
+        job.origin[1] = origin.y;
+        job.origin[2] = origin.z;
+        job.slot = chunk.GpuSlot;
+        job.terrain = terrains[chunk.GpuTerrain];
+    }
+
+    inline bool hasFills(uint32_t currentFrame){ return jobCount[currentFrame] > 0; }
+
+    //records the frame's fills into cellBuffer, see GpuChunkMesher::RecordDispatch's writeCells
+    void RecordFills(VkCommandBuffer commandBuffer, uint32_t currentFrame, VkBuffer cellBuffer){
+        uint32_t jobs = jobCount[currentFrame];
+        jobCount[currentFrame] = 0;
+        if(jobs == 0) return;
+
+        //the cell buffer was just copied into if it grew, and earlier frames' meshing may still read other slots of it
+        barrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+        //the frame's fence has signaled, nothing uses its set
+        if(boundBuffers[currentFrame][0] != cellBuffer || boundBuffers[currentFrame][1] != jobBuffers[currentFrame]){
+            writeDescriptorSet(currentFrame, cellBuffer, jobBuffers[currentFrame]);
+            boundBuffers[currentFrame][0] = cellBuffer;
+            boundBuffers[currentFrame][1] = jobBuffers[currentFrame];
+        }
+        recordJobs(commandBuffer, currentFrame, jobs);
+
+        //the staged cells copied in after, and the meshing that reads them
+        barrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT);
+    }
+
+private:
+    void recordJobs(VkCommandBuffer commandBuffer, uint32_t set, uint32_t jobs){
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSets[set], 0, nullptr);
+
+        for(uint32_t first = 0; first < jobs; first += maxJobsPerDispatch){
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &first);
+            vkCmdDispatch(commandBuffer, GROUPS_PER_JOB, std::min(maxJobsPerDispatch, jobs - first), 1);
+        }
+    }
+
+    void createPipeline(){
+        VkDevice& device = deviceHandler->getLogicalDevice();
+
+        //what is written (the cells or the heights), the jobs
+        std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+        for(uint32_t i = 0; i < bindings.size(); ++i){
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        if(vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) throw std::runtime_error("Failed to create terrain descriptor set layout.\n");
+
+        //the first job of the dispatch
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(uint32_t);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if(vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) throw std::runtime_error("Failed to create terrain pipeline layout.\n");
+
+        //only needed at pipeline creation time
+        ShaderHandler shaderHandler("shaders/terrain.spv", device);
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shaderHandler.getComputeShaderModule();
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+
+        if(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) throw std::runtime_error("Failed to create terrain pipeline.\n");
+    }
+
+    void createDescriptorSets(){
+        VkDevice& device = deviceHandler->getLogicalDevice();
+
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount = 2 * (MAX_FRAMES_IN_FLIGHT + 1);
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT + 1;
+
+        if(vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) throw std::runtime_error("Failed to create terrain descriptor pool.\n");
+
+        std::array<VkDescriptorSetLayout, MAX_FRAMES_IN_FLIGHT + 1> layouts;
+        layouts.fill(descriptorSetLayout);
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = MAX_FRAMES_IN_FLIGHT + 1;
+        allocInfo.pSetLayouts = layouts.data();
+
+        if(vkAllocateDescriptorSets(device, &allocInfo, descriptorSets) != VK_SUCCESS) throw std::runtime_error("Failed to allocate terrain descriptor sets.\n");
+    }
+
+    void writeDescriptorSet(uint32_t set, VkBuffer output, VkBuffer jobs){
+        VkBuffer buffers[2] = { output, jobs };
+
+        std::array<VkDescriptorBufferInfo, 2> bufferInfos{};
+        std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+        for(uint32_t i = 0; i < 2; ++i){
+            bufferInfos[i].buffer = buffers[i];
+            bufferInfos[i].offset = 0;
+            bufferInfos[i].range = VK_WHOLE_SIZE;
+
+            descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[i].dstSet = descriptorSets[set];
+            descriptorWrites[i].dstBinding = i;
+            descriptorWrites[i].dstArrayElement = 0;
+            descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrites[i].descriptorCount = 1;
+            descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+        }
+
+        vkUpdateDescriptorSets(deviceHandler->getLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+
+    //throws if the memory can't be mapped, buffer, memory and mapped are left as they were then
+    void createHostBuffer(VkDeviceSize size, VkBuffer& buffer, VkDeviceMemory& memory, void*& mapped){
+        VkBuffer newBuffer;
+        VkDeviceMemory newMemory;
+        void* newMapped;
+        BufferHelpers::CreateBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, newBuffer, newMemory, deviceHandler);
+        if(vkMapMemory(deviceHandler->getLogicalDevice(), newMemory, 0, size, 0, &newMapped) != VK_SUCCESS){
+            destroyHostBuffer(newBuffer, newMemory);
+            throw std::runtime_error("Failed to map terrain generation host buffer.\n");
+        }
+
+        buffer = newBuffer;
+        memory = newMemory;
+        mapped = newMapped;
+    }
+
+    //handles that were never created are VK_NULL_HANDLE, which every destroy call ignores
+    void destroy(){
+        VkDevice& device = deviceHandler->getLogicalDevice();
+        vkDestroyPipeline(device, pipeline, nullptr);
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+
+        for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) destroyHostBuffer(jobBuffers[i], jobBuffersMemory[i]);
+    }
+
+    void destroyHostBuffer(VkBuffer buffer, VkDeviceMemory memory){
+        if(buffer == VK_NULL_HANDLE) return;
+        vkDestroyBuffer(deviceHandler->getLogicalDevice(), buffer, nullptr);
+        deviceHandler->freeMemory(memory); //unmapped implicitly
+    }
+
+    void barrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess){
+        VkMemoryBarrier memoryBarrier{};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = srcAccess;
+        memoryBarrier.dstAccessMask = dstAccess;
+        vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+};
@@ -4,7 +4,6 @@
 #include <GLFW/glfw3.h>
 //vulkan.h is loaded above
 
-#include "SwapchainHandler.h"
 #include "ShaderHandler.h"
 #include "Vertex.h"
 
@@ -13,10 +12,10 @@ class GraphicsPipelineHandler{
 	VkPipeline graphicsPipeline;
 
     VkDevice& logicalDevice;
-    SwapchainHandler* swapchainHandler;
+    VkExtent2D& extent; //swapchain or offscreen target extent
 
 public:
-    GraphicsPipelineHandler(VkDevice& _ld, SwapchainHandler* _sh,  VkDescriptorSetLayout& descriptorSetLayout, VkRenderPass& renderPass) : logicalDevice(_ld), swapchainHandler(_sh){
+    GraphicsPipelineHandler(VkDevice& _ld, VkExtent2D& _extent,  VkDescriptorSetLayout& descriptorSetLayout, VkRenderPass& renderPass) : logicalDevice(_ld), extent(_extent){
         createGraphicsPipeline(descriptorSetLayout, renderPass);
     }
 
@@ -63,15 +62,15 @@ private:
         VkViewport viewport{};
         viewport.x = 0.0f;
         viewport.y = 0.0f;
-        viewport.width = (float) swapchainHandler->getSwapchainExtent().width;
-        viewport.height = (float) swapchainHandler->getSwapchainExtent().height;
+        viewport.width = (float) extent.width;
+        viewport.height = (float) extent.height;
         viewport.minDepth = 0.0f;
         viewport.maxDepth = 1.0f;
 
         //scissor = where pixels are actually stored (filters out what is not needed)
         VkRect2D scissor{};
         scissor.offset = {0, 0};
-        scissor.extent = swapchainHandler->getSwapchainExtent();
+        scissor.extent = extent;
 
         //things about the render pipeline we want control over during runtime (most everything else is baked and immutable)
         std::vector<VkDynamicState> dynamicStates = {
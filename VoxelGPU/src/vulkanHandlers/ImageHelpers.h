@@ -9,17 +9,16 @@
 #include "BufferHelpers.h"
 
 namespace ImageHelpers {
-    void CreateImage(
+    //creates the image only, for binding to memory that already exists (see DepthResourcesHandler)
+    VkImage CreateImageWithoutMemory(
         uint32_t width,
         uint32_t height,
         uint32_t mipLevels,
         VkFormat format,
         VkImageTiling tiling,
         VkImageUsageFlags usage,
-        VkMemoryPropertyFlags properties,
-        VkImage& image,
-        VkDeviceMemory& imageMemory,
-        DeviceHandler*& deviceHandler
+        DeviceHandler*& deviceHandler,
+        uint32_t arrayLayers = 1
     ){
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -28,7 +27,7 @@ namespace ImageHelpers {
         imageInfo.extent.height = height;
         imageInfo.extent.depth = 1;
         imageInfo.mipLevels = mipLevels;
-        imageInfo.arrayLayers = 1;
+        imageInfo.arrayLayers = arrayLayers;
         imageInfo.format = format;
         imageInfo.tiling = tiling;
         imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -37,8 +36,27 @@ namespace ImageHelpers {
         imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
         imageInfo.flags = 0; //optional
 
+        VkImage image;
         if(vkCreateImage(deviceHandler->getLogicalDevice(), &imageInfo, nullptr, &image) != VK_SUCCESS) throw std::runtime_error("Failed to create VkImage.\n");
 
+        return image;
+    }
+
+    void CreateImage(
+        uint32_t width,
+        uint32_t height,
+        uint32_t mipLevels,
+        VkFormat format,
+        VkImageTiling tiling,
+        VkImageUsageFlags usage,
+        VkMemoryPropertyFlags properties,
+        VkImage& image,
+        VkDeviceMemory& imageMemory,
+        DeviceHandler*& deviceHandler,
+        uint32_t arrayLayers = 1
+    ){
+        image = CreateImageWithoutMemory(width, height, mipLevels, format, tiling, usage, deviceHandler, arrayLayers);
+
         VkMemoryRequirements memReq;
         vkGetImageMemoryRequirements(deviceHandler->getLogicalDevice(), image, &memReq);
 
@@ -47,21 +65,21 @@ namespace ImageHelpers {
         allocInfo.allocationSize = memReq.size;
         allocInfo.memoryTypeIndex = BufferHelpers::FindMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, deviceHandler);
 
-        if(vkAllocateMemory(deviceHandler->getLogicalDevice(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) throw std::runtime_error("Failed to allocate image memory!\n");
+        if(deviceHandler->allocateMemory(allocInfo, imageMemory) != VK_SUCCESS) throw std::runtime_error("Failed to allocate image memory!\n");
         vkBindImageMemory(deviceHandler->getLogicalDevice(), image, imageMemory, 0);
     }
 
-    VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, VkDevice& logicalDevice) {
+    VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, VkDevice& logicalDevice, VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D, uint32_t layerCount = 1) {
         VkImageViewCreateInfo viewInfo{};
         viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
         viewInfo.image = image;
-        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.viewType = viewType;
         viewInfo.format = format;
         viewInfo.subresourceRange.aspectMask = aspectFlags;
         viewInfo.subresourceRange.baseMipLevel = 0;
         viewInfo.subresourceRange.levelCount = mipLevels;
         viewInfo.subresourceRange.baseArrayLayer = 0;
-        viewInfo.subresourceRange.layerCount = 1;
+        viewInfo.subresourceRange.layerCount = layerCount;
 
         VkImageView imageView;
         if (vkCreateImageView(logicalDevice, &viewInfo, nullptr, &imageView) != VK_SUCCESS) throw std::runtime_error("failed to create image view!");
@@ -69,7 +87,7 @@ namespace ImageHelpers {
         return imageView;
     }
 
-    void TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels,CommandBuffersHandler*& commandBuffersHandler) {
+    void TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels,CommandBuffersHandler*& commandBuffersHandler, uint32_t layerCount = 1) {
         VkCommandBuffer commandBuffer = commandBuffersHandler->beginSingleTimeCommands();
 
         VkImageMemoryBarrier barrier{};
@@ -83,7 +101,7 @@ namespace ImageHelpers {
         barrier.subresourceRange.baseMipLevel = 0;
         barrier.subresourceRange.levelCount = mipLevels;
         barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount = 1;
+        barrier.subresourceRange.layerCount = layerCount;
 
         VkPipelineStageFlags sourceStage;
         VkPipelineStageFlags destinationStage;
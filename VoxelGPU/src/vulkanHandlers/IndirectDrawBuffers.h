@@ -0,0 +1,62 @@
+#pragma once
+
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+//vulkan.h is loaded above
+
+#include <algorithm>
+#include "DeviceHandler.h"
+#include "BufferHelpers.h"
+
+//per frame host visible buffers of VkDrawIndexedIndirectCommand, one per draw range of the scene, so a recording task can
+//issue its whole slice of the scene with one vkCmdDrawIndexedIndirect (needs the multiDrawIndirect feature)
+//a frame's commands are only rewritten when its scene commands are recorded again, reused secondaries keep reading them
+class IndirectDrawBuffers{
+    VkBuffer buffers[MAX_FRAMES_IN_FLIGHT] = {};
+    VkDeviceMemory buffersMemory[MAX_FRAMES_IN_FLIGHT] = {};
+    void* buffersMapped[MAX_FRAMES_IN_FLIGHT] = {};
+    uint32_t capacity[MAX_FRAMES_IN_FLIGHT] = {}; //commands
+
+    DeviceHandler* deviceHandler;
+
+public:
+    IndirectDrawBuffers(DeviceHandler* _dh) : deviceHandler(_dh){}
+
+    ~IndirectDrawBuffers(){
+        for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) destroyBuffer(i);
+    }
+
+    inline VkBuffer& getBuffer(uint32_t currentFrame){ return buffers[currentFrame]; }
+
+    //after the frame's fence has signaled, room for count commands, valid until the next call for this frame
+    //growing replaces the frame's buffer, so its scene commands have to be recorded again (they are whenever this is called)
+    VkDrawIndexedIndirectCommand* Reserve(uint32_t currentFrame, uint32_t count){
+        if(count > capacity[currentFrame]){
+            destroyBuffer(currentFrame);
+            capacity[currentFrame] = std::max(count, std::max(capacity[currentFrame] * 2, 256u));
+
+            VkDeviceSize size = sizeof(VkDrawIndexedIndirectCommand) * (VkDeviceSize)capacity[currentFrame];
+            BufferHelpers::CreateBuffer(size, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffers[currentFrame], buffersMemory[currentFrame], deviceHandler);
+            vkMapMemory(deviceHandler->getLogicalDevice(), buffersMemory[currentFrame], 0, size, 0, &buffersMapped[currentFrame]);
+        }
+        return (VkDrawIndexedIndirectCommand*)buffersMapped[currentFrame];
+    }
+
+    //commands [first, first + count) of the frame's buffer, split where the device can't take them in one draw
+    void RecordDraws(VkCommandBuffer commandBuffer, uint32_t currentFrame, uint32_t first, uint32_t count){
+        uint32_t maxCount = deviceHandler->getMaxDrawIndirectCount();
+        for(uint32_t done = 0; done < count; done += maxCount){
+            VkDeviceSize offset = sizeof(VkDrawIndexedIndirectCommand) * (VkDeviceSize)(first + done);
+            vkCmdDrawIndexedIndirect(commandBuffer, buffers[currentFrame], offset, std::min(maxCount, count - done), sizeof(VkDrawIndexedIndirectCommand));
+        }
+    }
+
+private:
+    void destroyBuffer(size_t frame){
+        if(buffers[frame] == VK_NULL_HANDLE) return;
+        vkDestroyBuffer(deviceHandler->getLogicalDevice(), buffers[frame], nullptr);
+        deviceHandler->freeMemory(buffersMemory[frame]); //unmapped implicitly
+        buffers[frame] = VK_NULL_HANDLE;
+    }
+};
@@ -3,6 +3,7 @@
 #include <vector>
 #include <stdexcept>
 #include <iostream>
+#include <cstring>
 
 #include "Globals.h"
 
@@ -18,10 +19,15 @@
 
 class InstanceHandler{
     VkInstance instance;
+    bool properties2Supported = false;
 public:
     inline VkInstance& getInstance() { return instance; }
 
-    InstanceHandler(const std::vector<const char*>& validationLayers){
+    //VK_KHR_get_physical_device_properties2, the instance is 1.0 so extended device queries (like the memory budget) need it
+    inline bool hasProperties2() { return properties2Supported; }
+
+    //headless instances don't enable any window system extensions, so glfw doesn't need to be initialized
+    InstanceHandler(const std::vector<const char*>& validationLayers, bool headless = false){
         if(enableValidationLayers && !checkValidationLayerSupport(validationLayers)) throw std::runtime_error("Validation layer(s) requested, but not available\n");
 
         //technically optional, but provides useful optimization info to the driver
@@ -40,10 +46,10 @@ public:
 
         //vulkan is platform agnostic, so an extension is needed to interact with the windowing system of the OS
         uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
+        const char** glfwExtensions = nullptr;
 
         //glfw handles this for us
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        if(!headless) glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
         //count all available extensions
         uint32_t extensionCount = 0;
@@ -58,8 +64,16 @@ public:
         std::cout << "Available extensions:\n";
         for(const auto& e : extensions) std::cout << '\t' << e.extensionName << '\n';
 
-        createInfo.enabledExtensionCount = glfwExtensionCount;
-        createInfo.ppEnabledExtensionNames = glfwExtensions;
+        std::vector<const char*> enabledExtensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+
+        //optional
+        for(const auto& e : extensions){
+            if(strcmp(e.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0) properties2Supported = true;
+        }
+        if(properties2Supported) enabledExtensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         createInfo.enabledLayerCount = 0;
 
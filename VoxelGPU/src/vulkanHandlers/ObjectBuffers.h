@@ -0,0 +1,81 @@
+#pragma once
+
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+//vulkan.h is loaded above
+
+#include <glm/glm.hpp>
+#include <cstring>
+#include "DeviceHandler.h"
+#include "BufferHelpers.h"
+
+//per frame storage buffers holding one model matrix per scene object, indexed by Vertex::objectIndex in the vertex shader
+//like UniformBuffers they stay mapped, so moving an object is a matrix write and a copy instead of rebuilding the vertex buffer
+class ObjectBuffers{
+	std::vector<VkBuffer> objectBuffers;
+	std::vector<VkDeviceMemory> objectBuffersMemory;
+	std::vector<void*> objectBuffersMapped;
+	uint32_t capacity; //matrices per buffer
+
+	//what each frame's buffer holds, so unchanged matrices aren't copied again
+	const glm::mat4* uploadedSource[MAX_FRAMES_IN_FLIGHT] = {};
+	uint64_t uploadedVersion[MAX_FRAMES_IN_FLIGHT] = {};
+
+    DeviceHandler* deviceHandler;
+
+public:
+    ObjectBuffers(DeviceHandler* _dh, uint32_t _capacity = 1024) : capacity(_capacity), deviceHandler(_dh){
+        createObjectBuffers();
+    }
+
+    ~ObjectBuffers(){
+        destroyObjectBuffers();
+    }
+
+	inline std::vector<VkBuffer>& getBuffers(){ return objectBuffers; }
+	inline uint32_t getCapacity(){ return capacity; }
+	inline VkDeviceSize getBufferSize(){ return sizeof(glm::mat4) * capacity; }
+
+	//none of the buffers may be in use, the descriptor sets pointing at them have to be updated afterwards
+	void Resize(uint32_t _capacity){
+		destroyObjectBuffers();
+		capacity = _capacity;
+		createObjectBuffers();
+	}
+
+	//version changes whenever the matrices do, count must not exceed getCapacity()
+	void Upload(uint32_t currentFrame, const glm::mat4* matrices, uint32_t count, uint64_t version){
+		if(uploadedSource[currentFrame] == matrices && uploadedVersion[currentFrame] == version) return;
+
+		memcpy(objectBuffersMapped[currentFrame], matrices, sizeof(glm::mat4) * count);
+		uploadedSource[currentFrame] = matrices;
+		uploadedVersion[currentFrame] = version;
+	}
+
+private:
+	void createObjectBuffers(){
+		VkDeviceSize bufferSize = getBufferSize();
+
+		objectBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+		objectBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
+		objectBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+
+		for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i){
+			BufferHelpers::CreateBuffer(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, objectBuffers[i], objectBuffersMemory[i], deviceHandler);
+			vkMapMemory(deviceHandler->getLogicalDevice(), objectBuffersMemory[i], 0, bufferSize, 0, &objectBuffersMapped[i]);
+
+			//object 0 is the identity for baked geometry, it must be valid even before the first upload
+			glm::mat4 identity(1.0f);
+			memcpy(objectBuffersMapped[i], &identity, sizeof(identity));
+			uploadedSource[i] = nullptr;
+		}
+	}
+
+	void destroyObjectBuffers(){
+		for(size_t i = 0; i < objectBuffers.size(); ++i){
+			vkDestroyBuffer(deviceHandler->getLogicalDevice(), objectBuffers[i], nullptr);
+			deviceHandler->freeMemory(objectBuffersMemory[i]); //unmapped implicitly
+		}
+	}
+};
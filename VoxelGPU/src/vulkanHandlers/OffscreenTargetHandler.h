@@ -0,0 +1,173 @@
+#pragma once
+
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+//vulkan.h is loaded above
+
+#include <vector>
+#include <array>
+#include <fstream>
+
+#include "DeviceHandler.h"
+#include "RenderPassHandler.h"
+#include "CommandBuffersHandler.h"
+#include "ImageHelpers.h"
+#include "BufferHelpers.h"
+#include "DepthResourcesHandler.h"
+
+//stands in for the swapchain when rendering headless: one color image + framebuffer per frame in flight, sharing a depth buffer
+//the render pass leaves the color images in TRANSFER_SRC_OPTIMAL so finished frames can be copied out with SaveFrame()
+class OffscreenTargetHandler{
+    std::vector<VkImage> colorImages;
+    std::vector<VkDeviceMemory> colorImagesMemory;
+    std::vector<VkImageView> colorImageViews;
+    VkFormat colorFormat = VK_FORMAT_R8G8B8A8_UNORM; //byte order matches what SaveFrame writes out
+    VkExtent2D extent;
+
+    std::vector<VkFramebuffer> framebuffers;
+
+    DepthResourcesHandler* depthResourcesHandler;
+
+    DeviceHandler* deviceHandler;
+
+public:
+    OffscreenTargetHandler(DeviceHandler* _dh, uint32_t width, uint32_t height) : deviceHandler(_dh){
+        extent = { width, height };
+        createColorImages();
+        depthResourcesHandler = new DepthResourcesHandler(deviceHandler, extent);
+    }
+
+    ~OffscreenTargetHandler(){
+        VkDevice& device = deviceHandler->getLogicalDevice();
+
+        delete depthResourcesHandler;
+        for(auto framebuffer : framebuffers) vkDestroyFramebuffer(device, framebuffer, nullptr);
+        for(size_t i = 0; i < colorImages.size(); ++i){
+            vkDestroyImageView(device, colorImageViews[i], nullptr);
+            vkDestroyImage(device, colorImages[i], nullptr);
+            deviceHandler->freeMemory(colorImagesMemory[i]);
+        }
+    }
+
+    inline VkFormat& getColorFormat() { return colorFormat; }
+    inline VkExtent2D& getExtent() { return extent; }
+    inline std::vector<VkFramebuffer>& getFramebuffers() { return framebuffers; }
+    inline VkFormat findDepthFormat() { return depthResourcesHandler->findDepthFormat(); }
+
+    void createInitialFrameBuffers(RenderPassHandler*& renderPassHandler){
+        framebuffers.resize(colorImageViews.size());
+
+        for(size_t i = 0; i < colorImageViews.size(); ++i){
+            std::array<VkImageView, 2> attachments = {
+                colorImageViews[i],
+                depthResourcesHandler->getDepthImageView()
+            };
+
+            VkFramebufferCreateInfo framebufferInfo{};
+            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass = renderPassHandler->getRenderPass();
+            framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+            framebufferInfo.pAttachments = attachments.data();
+            framebufferInfo.width = extent.width;
+            framebufferInfo.height = extent.height;
+            framebufferInfo.layers = 1;
+
+            if(vkCreateFramebuffer(deviceHandler->getLogicalDevice(), &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS) throw std::runtime_error("Failed to create offscreen framebuffer.\n");
+        }
+    }
+
+    //copies the color image of a finished frame into host memory and writes it as a binary PPM
+    //the caller must make sure the frame's fence has signaled
+    void SaveFrame(uint32_t imageIndex, const char* path, CommandBuffersHandler*& commandBuffersHandler){
+        VkDevice& device = deviceHandler->getLogicalDevice();
+        VkDeviceSize imageSize = (VkDeviceSize)extent.width * extent.height * 4;
+
+        VkBuffer readbackBuffer;
+        VkDeviceMemory readbackBufferMemory;
+        BufferHelpers::CreateBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readbackBuffer, readbackBufferMemory, deviceHandler);
+
+        VkCommandBuffer commandBuffer = commandBuffersHandler->beginSingleTimeCommands();
+
+        //the render pass already transitioned the image, but its color writes still have to be made visible to the copy
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = colorImages[imageIndex];
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0; //tightly packed
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { extent.width, extent.height, 1 };
+
+        vkCmdCopyImageToBuffer(commandBuffer, colorImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+
+        //make the copy visible to the host once the fence in endSingleTimeCommands is waited on
+        VkMemoryBarrier hostBarrier{};
+        hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+        commandBuffersHandler->endSingleTimeCommands(commandBuffer);
+
+        void* data;
+        vkMapMemory(device, readbackBufferMemory, 0, imageSize, 0, &data);
+
+        std::ofstream file(path, std::ios::binary);
+        if(!file.is_open()){
+            vkUnmapMemory(device, readbackBufferMemory);
+            vkDestroyBuffer(device, readbackBuffer, nullptr);
+            deviceHandler->freeMemory(readbackBufferMemory);
+            throw std::runtime_error(std::string("Failed to open frame dump file: ") + path + '\n');
+        }
+
+        //PPM has no alpha, drop every 4th byte
+        file << "P6\n" << extent.width << ' ' << extent.height << "\n255\n";
+        const uint8_t* pixels = static_cast<const uint8_t*>(data);
+        std::vector<uint8_t> row(extent.width * 3);
+        for(uint32_t y = 0; y < extent.height; ++y){
+            const uint8_t* src = pixels + (size_t)y * extent.width * 4;
+            for(uint32_t x = 0; x < extent.width; ++x){
+                row[x * 3 + 0] = src[x * 4 + 0];
+                row[x * 3 + 1] = src[x * 4 + 1];
+                row[x * 3 + 2] = src[x * 4 + 2];
+            }
+            file.write(reinterpret_cast<const char*>(row.data()), row.size());
+        }
+
+        vkUnmapMemory(device, readbackBufferMemory);
+        vkDestroyBuffer(device, readbackBuffer, nullptr);
+        deviceHandler->freeMemory(readbackBufferMemory);
+    }
+
+private:
+    void createColorImages(){
+        colorImages.resize(MAX_FRAMES_IN_FLIGHT);
+        colorImagesMemory.resize(MAX_FRAMES_IN_FLIGHT);
+        colorImageViews.resize(MAX_FRAMES_IN_FLIGHT);
+
+        for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i){
+            ImageHelpers::CreateImage(extent.width, extent.height, 1, colorFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImages[i], colorImagesMemory[i], deviceHandler);
+            colorImageViews[i] = ImageHelpers::CreateImageView(colorImages[i], colorFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1, deviceHandler->getLogicalDevice());
+        }
+    }
+};
@@ -11,9 +11,10 @@
 struct QueueFamilyIndices{
 	std::optional<uint32_t> graphicsFamily;
 	std::optional<uint32_t> presentFamily; //the queue that supports drawing and presenting may vary. You can create logic to prefer devices that have this as one queue for better performance
+	bool requiresPresent = true; //false when rendering headless, there is no surface to present to
 
 	bool isComplete(){
-		return graphicsFamily.has_value() && presentFamily.has_value();
+		return graphicsFamily.has_value() && (presentFamily.has_value() || !requiresPresent);
 	}
 
 	QueueFamilyIndices(){
@@ -23,9 +24,11 @@ struct QueueFamilyIndices{
 	QueueFamilyIndices(QueueFamilyIndices& other){
 		graphicsFamily = other.graphicsFamily;
 		presentFamily = other.presentFamily;
+		requiresPresent = other.requiresPresent;
 	}
 
-	QueueFamilyIndices(const VkPhysicalDevice& device, SurfaceHandler* surfaceHandler){		
+	//surfaceHandler may be nullptr for headless rendering
+	QueueFamilyIndices(const VkPhysicalDevice& device, SurfaceHandler* surfaceHandler) : requiresPresent(surfaceHandler != nullptr){		
 		uint32_t queueFamilyCount = 0;
 		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
 
@@ -36,9 +39,11 @@ struct QueueFamilyIndices{
 		for(const auto& queueFamily : queueFamilies){
 			if(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) graphicsFamily = i;
 
-			VkBool32 presentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surfaceHandler->getSurface(), &presentSupport);
-			if(presentSupport) presentFamily = i;
+			if(requiresPresent){
+				VkBool32 presentSupport = false;
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surfaceHandler->getSurface(), &presentSupport);
+				if(presentSupport) presentFamily = i;
+			}
 			
 			if(isComplete()) break;
 			++i;
@@ -11,8 +11,9 @@ class RenderPassHandler{
 	VkDevice& logicalDevice;
 
 public:
-	RenderPassHandler(VkDevice& _ld, VkFormat _swapchainImageFormat, VkFormat _depthFormat) : logicalDevice(_ld) {
-		createRenderPass(_swapchainImageFormat, _depthFormat);
+	//colorFinalLayout is PRESENT_SRC for the swapchain, TRANSFER_SRC when rendering offscreen so frames can be read back
+	RenderPassHandler(VkDevice& _ld, VkFormat _swapchainImageFormat, VkFormat _depthFormat, VkImageLayout _colorFinalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) : logicalDevice(_ld) {
+		createRenderPass(_swapchainImageFormat, _depthFormat, _colorFinalLayout);
 	}
 
 	~RenderPassHandler(){
@@ -22,7 +23,7 @@ public:
 	inline VkRenderPass& getRenderPass() { return renderPass; }
 
 private:
-    void createRenderPass(VkFormat swapchainImageFormat, VkFormat depthFormat){
+    void createRenderPass(VkFormat swapchainImageFormat, VkFormat depthFormat, VkImageLayout colorFinalLayout){
 		VkAttachmentDescription colorAttachment{};
 		colorAttachment.format = swapchainImageFormat;
 		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -45,7 +46,7 @@ private:
 		//image layout before the render pass begins
 		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; //we dont care what the previous was
 		//image layout to automatically convert to after the render pass
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		colorAttachment.finalLayout = colorFinalLayout;
 
         VkAttachmentDescription depthAttachment{};
         depthAttachment.format = depthFormat;
@@ -8,8 +8,9 @@
 
 
 class ShaderHandler{
-    VkShaderModule vertShaderModule;
-    VkShaderModule fragShaderModule;
+    VkShaderModule vertShaderModule = VK_NULL_HANDLE;
+    VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+    VkShaderModule computeShaderModule = VK_NULL_HANDLE;
     VkDevice& logicalDevice;
     
 public:
@@ -18,13 +19,20 @@ public:
         createShaderModule(fragShaderPath, fragShaderModule);
     }
 
+    //a lone compute shader
+    ShaderHandler(std::string computeShaderPath, VkDevice& _ld) : logicalDevice(_ld){
+        createShaderModule(computeShaderPath, computeShaderModule);
+    }
+
     ~ShaderHandler(){
+        vkDestroyShaderModule(logicalDevice, computeShaderModule, nullptr);
         vkDestroyShaderModule(logicalDevice, fragShaderModule, nullptr);
 		vkDestroyShaderModule(logicalDevice, vertShaderModule, nullptr);
     }
 
     inline VkShaderModule& getVertShaderModule() { return vertShaderModule; }
     inline VkShaderModule& getFragShaderModule() { return fragShaderModule; }
+    inline VkShaderModule& getComputeShaderModule() { return computeShaderModule; }
 
 private:
     void createShaderModule(std::string& filename, VkShaderModule& shaderModule){
@@ -18,6 +18,7 @@ class SwapchainHandler; //forward decl for DepthResourcesHandler
 #include "RenderPassHandler.h"
 #include "ImageHelpers.h"
 #include "DepthResourcesHandler.h"
+#include "DeletionQueueHandler.h"
 
 class SwapchainHandler{
     VkSwapchainKHR swapchain;
@@ -30,15 +31,21 @@ class SwapchainHandler{
 
 	DepthResourcesHandler* depthResourcesHandler;
 
+	VkPresentModeKHR requestedPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+	VkPresentModeKHR presentMode; //what was actually used, falls back to FIFO if the requested mode isn't supported
+
+	uint32_t generation = 0; //bumped on every recreation, anything recorded against the old extent/framebuffers is stale
+
     WindowHandler* windowHandler;
     SurfaceHandler* surfaceHandler;
     DeviceHandler* deviceHandler;
     RenderPassHandler* renderPassHandler;
+    DeletionQueueHandler* deletionQueue; //the old swapchain's resources are destroyed through here once its frames are done
 	
 public:
 
-    SwapchainHandler(WindowHandler* _wh, SurfaceHandler* _sh, DeviceHandler* _dh)
-    : windowHandler(_wh), surfaceHandler(_sh), deviceHandler(_dh)
+    SwapchainHandler(WindowHandler* _wh, SurfaceHandler* _sh, DeviceHandler* _dh, DeletionQueueHandler* _dq)
+    : windowHandler(_wh), surfaceHandler(_sh), deviceHandler(_dh), deletionQueue(_dq)
     {
         createSwapchain();
 		createImageViews();
@@ -55,6 +62,20 @@ public:
     inline VkExtent2D& getSwapchainExtent() { return swapchainExtent; }
     inline std::vector<VkFramebuffer>& getSwapchainFramebuffers(){ return swapchainFramebuffers; }
 	inline VkFormat findDepthFormat(){ return depthResourcesHandler->findDepthFormat(); }
+	inline uint32_t getGeneration(){ return generation; }
+	inline VkPresentModeKHR getPresentMode(){ return presentMode; }
+
+	//recreates the swapchain, so only call between frames
+	void setPresentMode(VkPresentModeKHR mode){
+		if(mode == requestedPresentMode) return;
+		requestedPresentMode = mode;
+		recreateSwapchain();
+	}
+
+	bool isPresentModeSupported(VkPresentModeKHR mode){
+		for(VkPresentModeKHR available : deviceHandler->UpdateSwapchainSupportDetails().presentModes) if(available == mode) return true;
+		return false;
+	}
 
 	void recreateSwapchain(){
 		int width = 0, height = 0;
@@ -65,14 +86,28 @@ public:
 			glfwWaitEvents();
 		}
 
-		vkDeviceWaitIdle(deviceHandler->getLogicalDevice());
+		//no vkDeviceWaitIdle, frames already in flight keep rendering into and presenting the old swapchain
+		//its images are handed over through oldSwapchain, everything else is destroyed once the last of those frames is done
+		VkSwapchainKHR oldSwapchain = swapchain;
+		std::vector<VkImageView> oldImageViews = std::move(swapchainImageViews);
+		std::vector<VkFramebuffer> oldFramebuffers = std::move(swapchainFramebuffers);
+		DepthResourcesHandler* oldDepthResourcesHandler = depthResourcesHandler;
+		swapchainImageViews.clear();
+		swapchainFramebuffers.clear();
 
-		cleanupSwapchain();
-		createSwapchain();
+		createSwapchain(oldSwapchain);
 		createImageViews();
-		delete depthResourcesHandler;
-		depthResourcesHandler = new DepthResourcesHandler(deviceHandler, swapchainExtent);
+		depthResourcesHandler = new DepthResourcesHandler(deviceHandler, swapchainExtent, oldDepthResourcesHandler); //reuses the old memory if it fits
 		createFramebuffers();
+		++generation;
+
+		VkDevice device = deviceHandler->getLogicalDevice();
+		deletionQueue->Defer([=](){
+			for(auto framebuffer : oldFramebuffers) vkDestroyFramebuffer(device, framebuffer, nullptr);
+			for(auto imageView : oldImageViews) vkDestroyImageView(device, imageView, nullptr);
+			delete oldDepthResourcesHandler;
+			vkDestroySwapchainKHR(device, oldSwapchain, nullptr);
+		});
 	}
 
     void cleanupSwapchain(){
@@ -89,11 +124,11 @@ public:
     }
 
 private:
-    void createSwapchain(){
+    void createSwapchain(VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE){
 		SwapchainSupportDetails& swapchainSupport = deviceHandler->UpdateSwapchainSupportDetails();
 
 		VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapchainSupport.formats);
-		VkPresentModeKHR presentMode = chooseSwapPresentMode(swapchainSupport.presentModes);
+		presentMode = chooseSwapPresentMode(swapchainSupport.presentModes);
 		VkExtent2D extent = chooseSwapExtent(swapchainSupport.capabilities);
 
 		//+1 because we don't want to have to wait on the driver to do internal operations before acquiring another image to render to
@@ -132,7 +167,7 @@ private:
 		createInfo.presentMode = presentMode;
 		createInfo.clipped = VK_TRUE; //if another window blocks some pixels on the screen, don't render those pixels
 		
-		createInfo.oldSwapchain = VK_NULL_HANDLE; //if a swap chain becomes invalid/unoptimized and is completely recreated, the onld one must go here (for a complex reason)
+		createInfo.oldSwapchain = oldSwapchain; //if a swap chain becomes invalid/unoptimized and is completely recreated, the onld one must go here (for a complex reason)
 
         VkDevice& device = deviceHandler->getLogicalDevice();
 
@@ -165,10 +200,10 @@ private:
 		 */
 		
 		//mailbox is a good tradeoff if energy use is not a concern. If it is (like in mobile devices), then FIFO_KHR is likely better
-		/*for(const auto& availablePresentMode : availablePresentModes){
-		if(availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) return availablePresentMode;
-		}*/
-
+		//so it's up to the user, see setPresentMode
+		for(const auto& availablePresentMode : availablePresentModes){
+			if(availablePresentMode == requestedPresentMode) return availablePresentMode;
+		}
 
 		//guaranteed to be available if anything
 		return VK_PRESENT_MODE_FIFO_KHR;
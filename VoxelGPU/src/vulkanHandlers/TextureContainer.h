@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+//vulkan.h is loaded above
+
+/* .vtex texture container, loosely modelled after KTX2:
+ *
+ * [Header]
+ * [LevelIndex x mipLevels]   level 0 is the full resolution image
+ * [level data...]            each level starts on a DATA_ALIGNMENT boundary, tightly packed rows/blocks
+ *
+ * The level data is exactly what vkCmdCopyBufferToImage expects, so the loader can copy the
+ * mapped file straight into a staging buffer and upload every mip level in a single submit.
+ * Files are produced offline by the TextureConverter tool.
+ */
+namespace TextureContainer {
+	const uint32_t MAGIC = 0x58455456; //"VTEX" little endian
+	const uint32_t VERSION = 1;
+	const uint64_t DATA_ALIGNMENT = 16; //BC blocks are 8 or 16 bytes, keeps every level offset a multiple of both
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t format; //a VkFormat
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipLevels;
+		uint32_t layers; //always 1 for now
+		uint32_t reserved;
+	};
+
+	struct LevelIndex {
+		uint64_t offset; //from the start of the file
+		uint64_t size;
+	};
+
+	inline bool IsBlockCompressed(VkFormat format) {
+		switch (format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	//bytes per 4x4 block for BC formats, bytes per texel otherwise
+	inline uint32_t BytesPerBlock(VkFormat format) {
+		switch (format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			return 8;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			return 16;
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+			return 4;
+		default:
+			return 0; //unsupported
+		}
+	}
+
+	inline uint64_t LevelSize(VkFormat format, uint32_t width, uint32_t height) {
+		if (IsBlockCompressed(format)) return (uint64_t)((width + 3) / 4) * ((height + 3) / 4) * BytesPerBlock(format);
+		return (uint64_t)width * height * BytesPerBlock(format);
+	}
+
+	inline uint64_t AlignUp(uint64_t value) {
+		return (value + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+	}
+}
@@ -7,9 +7,14 @@
 #include <GLFW/glfw3.h>
 //vulkan.h is loaded above
 
+#include <string>
+#include <fstream>
+
 #include "ImageHelpers.h"
 #include "DeviceHandler.h"
 #include "CommandBuffersHandler.h"
+#include "TextureContainer.h"
+#include "src/MappedFile.h"
 
 class TextureHandler{   
     VkImage textureImage;
@@ -17,12 +22,37 @@ class TextureHandler{
     VkImageView textureImageView;
     VkSampler textureSampler; //doesn't necesarrily need to be tied to a texture, but I dont need this to be separate in this program
     uint32_t mipLevels;
+    uint32_t layers;
+    uint32_t texWidth;
+    uint32_t texHeight;
+    VkFormat imageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+    bool fromContainer = false; //containers carry their own mips, decoded images get them blitted
 
     DeviceHandler* deviceHandler;
 
 public:
-    TextureHandler(const char* path, DeviceHandler*& _dh, CommandBuffersHandler*& commandBuffersHandler) : deviceHandler(_dh){
-        createTextureImage(path, commandBuffersHandler);
+    TextureHandler(const char* path, DeviceHandler*& _dh, CommandBuffersHandler*& commandBuffersHandler) : TextureHandler(std::vector<const char*>{ path }, _dh, commandBuffersHandler) {}
+
+    //each path becomes one layer of a 2D array texture, indexed by material ID in the shaders
+    //all layers must share the same size, and all must be .vtex files of the same format or none of them
+    TextureHandler(const std::vector<const char*>& paths, DeviceHandler*& _dh, CommandBuffersHandler*& commandBuffersHandler) : deviceHandler(_dh), layers(static_cast<uint32_t>(paths.size())){
+        if(paths.empty()) throw std::runtime_error("A texture needs at least one image.\n");
+
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties(deviceHandler->getPhysicalDevice(), &properties);
+        if(layers > properties.limits.maxImageArrayLayers) throw std::runtime_error("Too many texture layers for this GPU.\n");
+
+        for(uint32_t layer = 0; layer < layers; ++layer){
+            //prefer a precompressed .vtex next to the source image if the converter has been run on it
+            std::string containerPath = getContainerPath(paths[layer]);
+
+            if(!containerPath.empty()) loadContainerLayer(containerPath.c_str(), layer, commandBuffersHandler);
+            else loadImageLayer(paths[layer], layer, commandBuffersHandler);
+        }
+
+        if(!fromContainer && mipLevels > 1) generateMipmaps(textureImage, texWidth, texHeight, mipLevels, commandBuffersHandler);
+        else ImageHelpers::TransitionImageLayout(textureImage, imageFormat, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels, commandBuffersHandler, layers);
+
         createTextureImageView();
         createTextureSampler();
     }
@@ -31,22 +61,132 @@ public:
         vkDestroySampler(deviceHandler->getLogicalDevice(), textureSampler, nullptr);
         vkDestroyImageView(deviceHandler->getLogicalDevice(), textureImageView, nullptr);
         vkDestroyImage(deviceHandler->getLogicalDevice(), textureImage, nullptr);
-        vkFreeMemory(deviceHandler->getLogicalDevice(), textureImageMemory, nullptr);
+        deviceHandler->freeMemory(textureImageMemory);
     }
 
     inline VkImageView getTextureImageView(){ return textureImageView; }
     inline VkSampler getTextureSampler() { return textureSampler; }
+    inline uint32_t getLayerCount() { return layers; }
 
 private:
-    void createTextureImage(const char* path, CommandBuffersHandler*& commandBuffersHandler){ //device handler needed for BufferHelpers
-        int texWidth, texHeight, texChannels;
-        stbi_uc* pixels = stbi_load(path, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-        VkDeviceSize imageSize = texWidth * texHeight * 4;
+    static std::string getContainerPath(const char* path){
+        std::string p(path);
+        size_t dot = p.find_last_of('.');
+        if(dot != std::string::npos && p.substr(dot) == ".vtex") return p;
+
+        std::string sibling = (dot == std::string::npos ? p : p.substr(0, dot)) + ".vtex";
+        return std::ifstream(sibling).good() ? sibling : std::string();
+    }
+
+    //the first layer decides the image's size, format and mip count, later layers have to match it
+    void createOrValidateImage(uint32_t layer, uint32_t width, uint32_t height, VkFormat format, uint32_t levels, bool container, CommandBuffersHandler*& commandBuffersHandler){
+        if(layer == 0){
+            texWidth = width;
+            texHeight = height;
+            imageFormat = format;
+            mipLevels = levels;
+            fromContainer = container;
+
+            VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+            if(!container) usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT; //blitted from for mips
+
+            ImageHelpers::CreateImage(texWidth, texHeight, mipLevels, imageFormat, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, deviceHandler, layers);
+            ImageHelpers::TransitionImageLayout(textureImage, imageFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels, commandBuffersHandler, layers);
+        }
+        else if(width != texWidth || height != texHeight || format != imageFormat || levels != mipLevels || container != fromContainer){
+            throw std::runtime_error("Texture array layers must all have the same size, format and mip count.\n");
+        }
+    }
+
+    //uploads every precomputed mip level as-is: no decoding and no blits
+    void loadContainerLayer(const char* path, uint32_t layer, CommandBuffersHandler*& commandBuffersHandler){
+        MappedFile file(path);
+        const uint8_t* bytes = file.getData();
+
+        if(file.getSize() < sizeof(TextureContainer::Header)) throw std::runtime_error("Texture container is truncated.\n");
+
+        const TextureContainer::Header* header = reinterpret_cast<const TextureContainer::Header*>(bytes);
+        if(header->magic != TextureContainer::MAGIC || header->version != TextureContainer::VERSION) throw std::runtime_error("Not a supported .vtex texture container.\n");
+
+        VkFormat format = static_cast<VkFormat>(header->format);
+        uint32_t levelCount = header->mipLevels;
+
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(deviceHandler->getPhysicalDevice(), format, &formatProperties);
+        if(!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) throw std::runtime_error("Texture container format is not supported by this GPU, reconvert it with --format rgba8.\n");
+
+        if(header->width == 0 || header->height == 0) throw std::runtime_error("Texture container is invalid.\n");
+        uint32_t maxLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(header->width, header->height)))) + 1;
+        if(levelCount == 0 || levelCount > maxLevels) throw std::runtime_error("Texture container is invalid.\n");
+
+        const TextureContainer::LevelIndex* levels = reinterpret_cast<const TextureContainer::LevelIndex*>(bytes + sizeof(TextureContainer::Header));
+        uint64_t indexEnd = sizeof(TextureContainer::Header) + sizeof(TextureContainer::LevelIndex) * levelCount;
+        if(indexEnd > file.getSize()) throw std::runtime_error("Texture container is truncated.\n");
+
+        //the level data is contiguous from the first level to the end of the last one: every level starts
+        //on the next aligned offset after the previous one and holds exactly what its extent needs
+        uint64_t dataStart = TextureContainer::AlignUp(indexEnd);
+        uint64_t dataEnd = dataStart;
+        for(uint32_t i = 0; i < levelCount; ++i){
+            uint64_t expectedSize = TextureContainer::LevelSize(format, std::max(header->width >> i, 1u), std::max(header->height >> i, 1u));
+            if(levels[i].offset != TextureContainer::AlignUp(dataEnd) || levels[i].size != expectedSize || expectedSize == 0) throw std::runtime_error("Texture container is invalid.\n");
+            if(levels[i].size > file.getSize() || levels[i].offset > file.getSize() - levels[i].size) throw std::runtime_error("Texture container is truncated.\n");
+            dataEnd = levels[i].offset + levels[i].size;
+        }
+
+        createOrValidateImage(layer, header->width, header->height, format, levelCount, true, commandBuffersHandler);
+
+        VkDeviceSize imageSize = dataEnd - dataStart;
+
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingBufferMemory;
+        BufferHelpers::CreateBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory, deviceHandler);
+
+        void* data;
+        vkMapMemory(deviceHandler->getLogicalDevice(), stagingBufferMemory, 0, imageSize, 0, &data);
+        memcpy(data, bytes + dataStart, static_cast<size_t>(imageSize)); //pages are read from disk as they are touched here
+        vkUnmapMemory(deviceHandler->getLogicalDevice(), stagingBufferMemory);
+
+        std::vector<VkBufferImageCopy> regions(levelCount);
+        for(uint32_t i = 0; i < levelCount; ++i){
+            regions[i] = {};
+            regions[i].bufferOffset = levels[i].offset - dataStart;
+            regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            regions[i].imageSubresource.mipLevel = i;
+            regions[i].imageSubresource.baseArrayLayer = layer;
+            regions[i].imageSubresource.layerCount = 1;
+            regions[i].imageExtent = { std::max(header->width >> i, 1u), std::max(header->height >> i, 1u), 1 };
+        }
+
+        VkCommandBuffer commandBuffer = commandBuffersHandler->beginSingleTimeCommands();
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+        commandBuffersHandler->endSingleTimeCommands(commandBuffer);
+
+        vkDestroyBuffer(deviceHandler->getLogicalDevice(), stagingBuffer, nullptr);
+        deviceHandler->freeMemory(stagingBufferMemory);
+
+        std::cout << "Loaded texture container " << path << ": " << header->width << 'x' << header->height << ", " << levelCount << " mip levels, " << imageSize << " bytes\n";
+    }
+
+    void loadImageLayer(const char* path, uint32_t layer, CommandBuffersHandler*& commandBuffersHandler){ //device handler needed for BufferHelpers
+        int width, height, texChannels;
+        stbi_uc* pixels = stbi_load(path, &width, &height, &texChannels, STBI_rgb_alpha);
+        VkDeviceSize imageSize = width * height * 4;
 
         if (!pixels)
             throw std::runtime_error("failed to load texture image!");
 
-        mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
+        uint32_t levels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+
+        //mips are generated with linear blits, so without linear filtering support only the base level is used
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(deviceHandler->getPhysicalDevice(), VK_FORMAT_R8G8B8A8_SRGB, &formatProperties);
+        if(!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)){
+            if(layer == 0) std::cout << "Texture format does not support linear blitting, textures will not be mipmapped. Convert them to .vtex to get precomputed mips.\n";
+            levels = 1;
+        }
+
+        createOrValidateImage(layer, static_cast<uint32_t>(width), static_cast<uint32_t>(height), VK_FORMAT_R8G8B8A8_SRGB, levels, false, commandBuffersHandler);
 
         VkBuffer stagingBuffer;
         VkDeviceMemory stagingBufferMemory;
@@ -59,20 +199,14 @@ private:
 
         stbi_image_free(pixels);
 
-        ImageHelpers::CreateImage(texWidth, texHeight, mipLevels, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, deviceHandler);
-
-        ImageHelpers::TransitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels, commandBuffersHandler);
-        copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), commandBuffersHandler);
-        //happens when generating mipmaps
-        //ImageHelpers::TransitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels, commandBuffersHandler);
+        copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(width), static_cast<uint32_t>(height), layer, commandBuffersHandler);
+        //the transition to SHADER_READ_ONLY happens when generating mipmaps, once every layer is uploaded
 
         vkDestroyBuffer(deviceHandler->getLogicalDevice(), stagingBuffer, nullptr);
-        vkFreeMemory(deviceHandler->getLogicalDevice(), stagingBufferMemory, nullptr);
-
-        generateMipmaps(textureImage, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, mipLevels, commandBuffersHandler);
+        deviceHandler->freeMemory(stagingBufferMemory);
     }
 
-    void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, CommandBuffersHandler*& commandBuffersHandler) {
+    void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layer, CommandBuffersHandler*& commandBuffersHandler) {
         VkCommandBuffer commandBuffer = commandBuffersHandler->beginSingleTimeCommands();
 
         VkBufferImageCopy region{};
@@ -81,7 +215,7 @@ private:
         region.bufferImageHeight = 0;
         region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
         region.imageSubresource.mipLevel = 0;
-        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.baseArrayLayer = layer;
         region.imageSubresource.layerCount = 1;
         region.imageOffset = {0, 0, 0};
         region.imageExtent = {
@@ -95,14 +229,8 @@ private:
         commandBuffersHandler->endSingleTimeCommands(commandBuffer);
     }
 
-    void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels, CommandBuffersHandler*& commandBuffersHandler) {
-        //check if image format supports linear blitting
-        VkFormatProperties formatProperties;
-        vkGetPhysicalDeviceFormatProperties(deviceHandler->getPhysicalDevice(), imageFormat, &formatProperties);
-
-        if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
-            throw std::runtime_error("texture image format does not support linear blitting!");
-
+    void generateMipmaps(VkImage image, int32_t texWidth, int32_t texHeight, uint32_t mipLevels, CommandBuffersHandler*& commandBuffersHandler) {
+        //linear blitting support is checked in loadImageLayer, every layer is blitted at once
         VkCommandBuffer commandBuffer = commandBuffersHandler->beginSingleTimeCommands();
 
         VkImageMemoryBarrier barrier{};
@@ -112,7 +240,7 @@ private:
         barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
         barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
         barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount = 1;
+        barrier.subresourceRange.layerCount = layers;
         barrier.subresourceRange.levelCount = 1;
 
         int32_t mipWidth = texWidth;
@@ -137,13 +265,13 @@ private:
             blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
             blit.srcSubresource.mipLevel = i - 1;
             blit.srcSubresource.baseArrayLayer = 0;
-            blit.srcSubresource.layerCount = 1;
+            blit.srcSubresource.layerCount = layers;
             blit.dstOffsets[0] = {0, 0, 0};
             blit.dstOffsets[1] = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 };
             blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
             blit.dstSubresource.mipLevel = i;
             blit.dstSubresource.baseArrayLayer = 0;
-            blit.dstSubresource.layerCount = 1;
+            blit.dstSubresource.layerCount = layers;
 
             vkCmdBlitImage(commandBuffer,
                 image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
@@ -183,7 +311,7 @@ private:
     
 
     void createTextureImageView(){
-        textureImageView = ImageHelpers::CreateImageView(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, deviceHandler->getLogicalDevice());
+        textureImageView = ImageHelpers::CreateImageView(textureImage, imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, deviceHandler->getLogicalDevice(), VK_IMAGE_VIEW_TYPE_2D_ARRAY, layers);
     }
 
     void createTextureSampler() {
@@ -0,0 +1,98 @@
+#pragma once
+
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+//vulkan.h is loaded above
+
+#include <vector>
+#include <array>
+
+#include "Globals.h"
+#include "src/Profiler.h"
+#include "DeviceHandler.h"
+
+//GPU timestamps around each pass of a frame, one block of queries per frame in flight
+//query 0 is written when the command buffer starts executing, query n + 1 when pass n has finished
+class TimestampQueryHandler{
+public:
+    static const uint32_t QUERIES_PER_FRAME = GPU_PASS_COUNT + 1;
+
+private:
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    bool supported = false;
+    float timestampPeriod = 1.0f; //nanoseconds per tick
+    uint64_t validBitsMask = ~0ull;
+
+    std::array<bool, MAX_FRAMES_IN_FLIGHT> pending{}; //queries of this frame were recorded and not read back yet
+
+    DeviceHandler* deviceHandler;
+
+public:
+    TimestampQueryHandler(DeviceHandler*& _dh) : deviceHandler(_dh){
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(deviceHandler->getPhysicalDevice(), &properties);
+
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(deviceHandler->getPhysicalDevice(), &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(deviceHandler->getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+        uint32_t validBits = queueFamilies[deviceHandler->getQueueFamilyIndices().graphicsFamily.value()].timestampValidBits;
+        if(validBits == 0 || properties.limits.timestampPeriod == 0.0f){
+            std::cout << "GPU timestamps are not supported on the graphics queue, GPU timings are disabled\n";
+            return;
+        }
+
+        supported = true;
+        timestampPeriod = properties.limits.timestampPeriod;
+        if(validBits < 64) validBitsMask = (1ull << validBits) - 1;
+
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = QUERIES_PER_FRAME * MAX_FRAMES_IN_FLIGHT;
+
+        if(vkCreateQueryPool(deviceHandler->getLogicalDevice(), &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS) throw std::runtime_error("Failed to create timestamp query pool.\n");
+    }
+
+    ~TimestampQueryHandler(){
+        if(queryPool != VK_NULL_HANDLE) vkDestroyQueryPool(deviceHandler->getLogicalDevice(), queryPool, nullptr);
+    }
+
+    inline bool isSupported() { return supported; }
+
+    //must be recorded outside of a render pass, before any pass of the frame
+    void BeginFrame(VkCommandBuffer commandBuffer, uint32_t currentFrame){
+        if(!supported) return;
+
+        vkCmdResetQueryPool(commandBuffer, queryPool, currentFrame * QUERIES_PER_FRAME, QUERIES_PER_FRAME);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, currentFrame * QUERIES_PER_FRAME);
+        pending[currentFrame] = true;
+    }
+
+    void EndPass(VkCommandBuffer commandBuffer, uint32_t currentFrame, GpuPass pass){
+        if(!supported) return;
+
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, currentFrame * QUERIES_PER_FRAME + pass + 1);
+    }
+
+    //call once the frame's fence has signaled, returns false if there is nothing to read
+    bool ReadResults(uint32_t currentFrame, float* passMs, float& totalMs){
+        if(!supported || !pending[currentFrame]) return false;
+
+        uint64_t timestamps[QUERIES_PER_FRAME];
+        VkResult result = vkGetQueryPoolResults(deviceHandler->getLogicalDevice(), queryPool, currentFrame * QUERIES_PER_FRAME, QUERIES_PER_FRAME,
+            sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+        if(result != VK_SUCCESS) return false; //VK_NOT_READY
+
+        pending[currentFrame] = false;
+
+        const float ticksToMs = timestampPeriod / 1000000.0f;
+        for(uint32_t i = 0; i < GPU_PASS_COUNT; ++i) passMs[i] = ((timestamps[i + 1] - timestamps[i]) & validBitsMask) * ticksToMs;
+        totalMs = ((timestamps[GPU_PASS_COUNT] - timestamps[0]) & validBitsMask) * ticksToMs;
+
+        return true;
+    }
+};
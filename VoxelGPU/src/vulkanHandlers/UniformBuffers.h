@@ -23,17 +23,16 @@ public:
 	std::vector<void*> uniformBuffersMapped;
 
     DeviceHandler* deviceHandler;
-	SwapchainHandler* swapchainHandler;
 
 public:
-    UniformBuffers(DeviceHandler* _dh, SwapchainHandler* _sh) : deviceHandler(_dh), swapchainHandler(_sh){ //device handler needed for buffer helpers
+    UniformBuffers(DeviceHandler* _dh) : deviceHandler(_dh){ //device handler needed for buffer helpers
         createUniformBuffers();
     }
 
     ~UniformBuffers(){
         for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i){
 			vkDestroyBuffer(deviceHandler->getLogicalDevice(), uniformBuffers[i], nullptr);
-			vkFreeMemory(deviceHandler->getLogicalDevice(), uniformBuffersMemory[i], nullptr);
+			deviceHandler->freeMemory(uniformBuffersMemory[i]);
 		}
     }
 